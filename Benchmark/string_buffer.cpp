@@ -0,0 +1,100 @@
+// Counts the heap allocations made for token lexemes while lexing MOCK_DATA.json,
+// with StringBuffer and with a replica of the previous calloc based buffer fed the
+// same tokens. Build from this directory: g++ -std=c++17 -O2 string_buffer.cpp
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static std::size_t allocations = 0;
+
+static void * counting_realloc( void * ptr, std::size_t size )
+{
+    ++allocations;
+    return std::realloc( ptr, size );
+}
+
+#define JPARSER_REALLOC( ptr, size ) counting_realloc( ( ptr ), ( size ) )
+#include "../jparser.hpp"
+
+using namespace JsonParser;
+
+// The buffer as it was: always calloc'ed (255 bytes unless told otherwise), grown by
+// allocating a block twice the size, copying and freeing the old one.
+struct LegacyStringBuffer
+{
+    char *data, *current, *end;
+    std::size_t size;
+
+    static std::size_t allocations;
+
+    explicit LegacyStringBuffer( std::size_t _size ):
+        data{ static_cast< char * >( calloc( _size, 1 ) ) }, current{ data }, end{ data + _size }, size{ _size }
+    {
+        ++allocations;
+    }
+    ~LegacyStringBuffer() { free( data ); }
+
+    void enlarge_space()
+    {
+        std::size_t new_size = size * 2;
+        char *new_data = static_cast< char * >( calloc( new_size, 1 ) );
+        ++allocations;
+        memcpy( new_data, data, size );
+        current = new_data + ( current - data );
+        free( data );
+        data = new_data;
+        end = data + new_size;
+        size = new_size;
+    }
+
+    void append( char const ch )
+    {
+        if( current + 1 >= end ){
+            enlarge_space();
+        }
+        *current++ = ch;
+    }
+};
+
+std::size_t LegacyStringBuffer::allocations = 0;
+
+// Initial size the previous lexer gave each kind of token.
+static std::size_t legacy_initial_size( TokenType type )
+{
+    switch( type )
+    {
+        case TokenType::Null: return 5;
+        case TokenType::Boolean: return 6;
+        case TokenType::String: case TokenType::Integer: return 255;
+        default: return 2;
+    }
+}
+
+int main()
+{
+    std::size_t tokens = 0;
+    auto const start = std::chrono::steady_clock::now();
+    {
+        Lexer lexer{ make_file_source( "MOCK_DATA.json" ) };
+        while( lexer.has_more_tokens() ){
+            Token const token = lexer.get_next_token();
+            if( token.get_type() == TokenType::Invalid ){
+                break;
+            }
+            ++tokens;
+
+            LegacyStringBuffer legacy{ legacy_initial_size( token.get_type() ) };
+            for( char ch: token.get_lexeme().view() ){
+                legacy.append( ch );
+            }
+        }
+    }
+    auto const elapsed = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - start );
+
+    std::printf( "tokens:                      %zu\n", tokens );
+    std::printf( "allocations, calloc buffer:  %zu\n", LegacyStringBuffer::allocations );
+    std::printf( "allocations, StringBuffer:   %zu\n", allocations );
+    std::printf( "time (both buffers):         %lld us\n", static_cast< long long >( elapsed.count() ) );
+    return 0;
+}
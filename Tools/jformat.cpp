@@ -0,0 +1,62 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "../jparser.hpp"
+
+using namespace JsonParser;
+
+void usage( char const * program )
+{
+    std::cerr << "Usage: " << program << " [--pretty[=INDENT]] [--no-validate] [INPUT|-] [OUTPUT]" << std::endl;
+    std::cerr << "Minifies (or with --pretty, re-indents) JSON read from INPUT, or stdin, into OUTPUT, or stdout." << std::endl;
+}
+
+int main( int argc, char **argv )
+{
+    FormatOptions options{};
+    char const *input = nullptr, *output = nullptr;
+
+    for( int i = 1; i != argc; ++i )
+    {
+        if( strcmp( argv[i], "--pretty" ) == 0 ){
+            options.pretty = true;
+        } else if( strncmp( argv[i], "--pretty=", 9 ) == 0 ){
+            options.pretty = true;
+            options.indent = std::strtoul( argv[i] + 9, nullptr, 10 );
+        } else if( strcmp( argv[i], "--no-validate" ) == 0 ){
+            options.validate = false;
+        } else if( strcmp( argv[i], "--help" ) == 0 || strcmp( argv[i], "-h" ) == 0 ){
+            usage( argv[0] );
+            return EXIT_SUCCESS;
+        } else if( !input ){
+            input = argv[i];
+        } else if( !output ){
+            output = argv[i];
+        } else {
+            usage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ios::sync_with_stdio( false );
+    try {
+        std::unique_ptr< InputSource > source = ( !input || strcmp( input, "-" ) == 0 ) ?
+                                                    make_input_source( std::cin ) : make_file_source( input );
+        if( output ){
+            std::ofstream file { output, std::ios::out | std::ios::binary };
+            if( !file ){
+                std::cerr << "Unable to open " << output << std::endl;
+                return EXIT_FAILURE;
+            }
+            format_json( std::move( source ), file, options );
+        } else {
+            format_json( std::move( source ), std::cout, options );
+        }
+    } catch( std::exception const & e ){
+        std::cout.flush();
+        std::cerr << "jformat: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,399 @@
+#ifndef COLUMNAR_TABLE_H_INCLUDED
+#define COLUMNAR_TABLE_H_INCLUDED
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Lexer.hpp"
+
+namespace JsonParser
+{
+    struct ColumnTypeMismatch: virtual std::runtime_error { ColumnTypeMismatch( std::string const & err ): std::runtime_error( err ){} };
+
+    enum class ColumnType
+    {
+        Null,
+        Integer,
+        Double,
+        Boolean,
+        String
+    };
+
+    inline char const * column_type_name( ColumnType type )
+    {
+        switch( type )
+        {
+            case ColumnType::Null: return "null";
+            case ColumnType::Integer: return "integer";
+            case ColumnType::Double: return "double";
+            case ColumnType::Boolean: return "boolean";
+            case ColumnType::String: return "string";
+        }
+        return "unknown";
+    }
+
+    // One typed column of a ColumnarTable. Values of a column are stored contiguously;
+    // string columns keep all their bytes in a single blob indexed by `offsets`, where
+    // the value of row i is bytes[ offsets[i], offsets[i + 1] ). Rows whose key was
+    // missing or null are flagged in `validity` and hold a zero/empty placeholder.
+    struct Column
+    {
+    private:
+        std::string m_name;
+        ColumnType m_type;
+        std::vector< std::uint8_t > m_validity;
+        std::vector< std::int64_t > m_integers;
+        std::vector< double > m_doubles;
+        std::vector< std::uint8_t > m_booleans;
+        std::vector< std::size_t > m_offsets;
+        std::string m_bytes;
+    public:
+        Column( std::string const & name, ColumnType type ): m_name{ name }, m_type{ ColumnType::Null }
+        {
+            become( type );
+        }
+
+        std::string const & name() const { return m_name; }
+        ColumnType type() const { return m_type; }
+        std::size_t size() const { return m_validity.size(); }
+        bool is_null( std::size_t row ) const { return m_validity[ row ] == 0; }
+
+        std::vector< std::int64_t > const & integers() const { return m_integers; }
+        std::vector< double > const & doubles() const { return m_doubles; }
+        std::vector< std::uint8_t > const & booleans() const { return m_booleans; }
+        std::vector< std::size_t > const & offsets() const { return m_offsets; }
+        std::string const & bytes() const { return m_bytes; }
+
+        std::string_view string_at( std::size_t row ) const
+        {
+            return std::string_view{ m_bytes }.substr( m_offsets[ row ], m_offsets[ row + 1 ] - m_offsets[ row ] );
+        }
+
+        void append_null()
+        {
+            m_validity.push_back( 0 );
+            append_placeholder();
+        }
+
+        void append( ColumnType value_type, std::string const & lexeme )
+        {
+            if( value_type == ColumnType::Null ){
+                append_null();
+                return;
+            }
+            if( m_type == ColumnType::Null ){
+                become( value_type );
+            } else if( m_type == ColumnType::Integer && value_type == ColumnType::Double ){
+                promote_to_double();
+            } else if( m_type != value_type && m_type != ColumnType::String &&
+                    !( m_type == ColumnType::Double && value_type == ColumnType::Integer ) )
+            {
+                throw ColumnTypeMismatch{ "Column '" + m_name + "' holds " + column_type_name( m_type ) +
+                                            " values, found a " + column_type_name( value_type ) + " at row " + std::to_string( size() ) };
+            }
+
+            m_validity.push_back( 1 );
+            switch( m_type )
+            {
+                case ColumnType::Integer:
+                    m_integers.push_back( std::strtoll( lexeme.c_str(), nullptr, 10 ) );
+                    break;
+                case ColumnType::Double:
+                    m_doubles.push_back( std::strtod( lexeme.c_str(), nullptr ) );
+                    break;
+                case ColumnType::Boolean:
+                    m_booleans.push_back( lexeme == "true" );
+                    break;
+                case ColumnType::String:
+                    m_bytes.append( lexeme );
+                    m_offsets.push_back( m_bytes.size() );
+                    break;
+                case ColumnType::Null:
+                    break;
+            }
+        }
+    private:
+        void append_placeholder()
+        {
+            switch( m_type )
+            {
+                case ColumnType::Integer: m_integers.push_back( 0 ); break;
+                case ColumnType::Double: m_doubles.push_back( 0.0 ); break;
+                case ColumnType::Boolean: m_booleans.push_back( 0 ); break;
+                case ColumnType::String: m_offsets.push_back( m_bytes.size() ); break;
+                case ColumnType::Null: break;
+            }
+        }
+
+        // a column that has only seen nulls so far takes the type of its first value
+        void become( ColumnType type )
+        {
+            m_type = type;
+            if( m_type == ColumnType::String ){
+                m_offsets.push_back( 0 );
+            }
+            for( std::size_t i = 0; i != size(); ++i ){
+                append_placeholder();
+            }
+        }
+
+        void promote_to_double()
+        {
+            m_doubles.reserve( m_integers.size() );
+            for( std::int64_t value: m_integers ){
+                m_doubles.push_back( static_cast< double >( value ) );
+            }
+            std::vector< std::int64_t >{}.swap( m_integers );
+            m_type = ColumnType::Double;
+        }
+    };
+
+    struct ColumnarTable
+    {
+    private:
+        std::vector< Column > m_columns;
+        std::unordered_map< std::string, std::size_t > m_index;
+        std::size_t m_rows = 0;
+    public:
+        std::size_t rows() const { return m_rows; }
+        std::size_t size() const { return m_columns.size(); }
+
+        Column const & operator []( std::size_t i ) const { return m_columns[ i ]; }
+
+        Column const * column( std::string const & name ) const
+        {
+            auto iter = m_index.find( name );
+            return iter == m_index.end() ? nullptr : &m_columns[ iter->second ];
+        }
+
+        std::vector< Column >::const_iterator begin() const { return m_columns.cbegin(); }
+        std::vector< Column >::const_iterator end() const { return m_columns.cend(); }
+    private:
+        friend struct ColumnarParser;
+
+        std::size_t column_index( std::string const & name )
+        {
+            auto iter = m_index.find( name );
+            if( iter != m_index.end() ){
+                return iter->second;
+            }
+            // a key first seen after some rows were stored is null in all of them
+            m_columns.emplace_back( name, ColumnType::Null );
+            for( std::size_t i = 0; i != m_rows; ++i ){
+                m_columns.back().append_null();
+            }
+            m_index.emplace( name, m_columns.size() - 1 );
+            return m_columns.size() - 1;
+        }
+    };
+
+    // Parses a top-level array of flat objects directly into a ColumnarTable, without
+    // building a JsonExpression per row. The column types are inferred from the first
+    // `inference_rows` rows (mixed types settle on a string column); afterwards an
+    // integer column still widens to double, and a new key adds a new column.
+    struct ColumnarParser
+    {
+    public:
+        ColumnarParser( std::string const & json_string, std::size_t inference_rows = 64 );
+        ColumnarParser( std::unique_ptr< InputSource > source, std::size_t inference_rows = 64 );
+
+        ColumnarTable & get_table() { return table; }
+    private:
+        struct Cell
+        {
+            std::size_t column;
+            ColumnType type;
+            std::string lexeme;
+        };
+        typedef std::vector< Cell > Row;
+
+        void parse();
+        void row( Row & );
+        void store_row( Row const & );
+        void infer_schema();
+
+        static ColumnType value_type( Token const & );
+        static ColumnType merge_types( ColumnType, ColumnType );
+    private:
+        ColumnarTable table;
+        Token current_token;
+        Lexer lexer;
+        std::size_t inference_rows;
+        std::vector< Row > pending_rows;
+        bool schema_inferred;
+    };
+
+    inline ColumnarParser::ColumnarParser( std::string const & json_string, std::size_t rows ):
+        table{},
+        current_token { ' ', TokenType::Invalid },
+        lexer{ json_string },
+        inference_rows{ rows },
+        schema_inferred{ false }
+    {
+        parse();
+    }
+
+    inline ColumnarParser::ColumnarParser( std::unique_ptr< InputSource > source, std::size_t rows ):
+        table{},
+        current_token { ' ', TokenType::Invalid },
+        lexer{ std::move( source ) },
+        inference_rows{ rows },
+        schema_inferred{ false }
+    {
+        parse();
+    }
+
+    inline void ColumnarParser::parse()
+    {
+        current_token = lexer.get_next_token();
+        if( current_token.get_type() != TokenType::Open_SquareBracket ){
+            throw JErrorMessages::InvalidToken { "Invalid Token found. Expected an array of objects at the start of document." };
+        }
+
+        current_token = lexer.get_next_token();
+        Row current_row{};
+        while( current_token.get_type() != TokenType::Close_SquareBracket ){
+            current_row.clear();
+            row( current_row );
+            if( !schema_inferred && pending_rows.size() < inference_rows ){
+                pending_rows.push_back( std::move( current_row ) );
+            } else {
+                infer_schema();
+                store_row( current_row );
+            }
+
+            if( current_token.get_type() != TokenType::Comma ){
+                break;
+            }
+            current_token = lexer.get_next_token();
+            if( current_token.get_type() != TokenType::Open_Braces ){
+                throw JErrorMessages::InvalidToken { "Expected an object before '" + current_token.get_lexeme().to_string() + "'" };
+            }
+        }
+        if( current_token.get_type() != TokenType::Close_SquareBracket ){
+            throw JErrorMessages::InvalidToken { "Expected a ',' or ']' before '" + current_token.get_lexeme().to_string() + "'" };
+        }
+        if( lexer.has_more_tokens() ){
+            throw JErrorMessages::InvalidToken { "Unexpected content after the end of document" };
+        }
+        infer_schema();
+    }
+
+    inline void ColumnarParser::row( Row & cells )
+    {
+        if( current_token.get_type() != TokenType::Open_Braces ){
+            throw JErrorMessages::InvalidToken { "Expected an object before '" + current_token.get_lexeme().to_string() + "'" };
+        }
+        current_token = lexer.get_next_token();
+
+        while( current_token.get_type() != TokenType::Close_Braces ){
+            if( current_token.get_type() != TokenType::String ){
+                throw JErrorMessages::InvalidToken { "Expected a string before '" + current_token.get_lexeme().to_string() + "'" };
+            }
+            std::size_t const column = table.column_index( current_token.get_lexeme().to_string() );
+
+            current_token = lexer.get_next_token();
+            if( current_token.get_type() != TokenType::Colon ){
+                throw JErrorMessages::InvalidToken{ "Expected a colon seperator before " + current_token.get_lexeme().to_string() };
+            }
+            current_token = lexer.get_next_token();
+            cells.push_back( Cell{ column, value_type( current_token ), current_token.get_lexeme().to_string() } );
+
+            current_token = lexer.get_next_token();
+            if( current_token.get_type() != TokenType::Comma ){
+                break;
+            }
+            current_token = lexer.get_next_token();
+            if( current_token.get_type() != TokenType::String ){
+                throw JErrorMessages::InvalidToken { "Expected a string before '" + current_token.get_lexeme().to_string() + "'" };
+            }
+        }
+        if( current_token.get_type() != TokenType::Close_Braces ){
+            throw JErrorMessages::InvalidToken { "Expected a ',' or '}' before '" + current_token.get_lexeme().to_string() + "'" };
+        }
+        current_token = lexer.get_next_token();
+    }
+
+    inline void ColumnarParser::infer_schema()
+    {
+        if( schema_inferred ){
+            return;
+        }
+        schema_inferred = true;
+
+        std::vector< ColumnType > types( table.size(), ColumnType::Null );
+        for( Row const & pending: pending_rows ){
+            for( Cell const & cell: pending ){
+                types[ cell.column ] = merge_types( types[ cell.column ], cell.type );
+            }
+        }
+        for( std::size_t i = 0; i != types.size(); ++i ){
+            table.m_columns[ i ] = Column{ table.m_columns[ i ].name(), types[ i ] };
+        }
+        for( Row const & pending: pending_rows ){
+            store_row( pending );
+        }
+        std::vector< Row >{}.swap( pending_rows );
+    }
+
+    inline void ColumnarParser::store_row( Row const & cells )
+    {
+        std::size_t const row_number = table.m_rows;
+        for( Cell const & cell: cells ){
+            Column & column = table.m_columns[ cell.column ];
+            if( column.size() > row_number ){
+                throw JErrorMessages::InvalidToken { "Duplicate key '" + column.name() + "' in row " + std::to_string( row_number ) };
+            }
+            column.append( cell.type, cell.lexeme );
+        }
+        ++table.m_rows;
+        for( Column & column: table.m_columns ){
+            if( column.size() < table.m_rows ){
+                column.append_null();
+            }
+        }
+    }
+
+    inline ColumnType ColumnarParser::value_type( Token const & token )
+    {
+        switch( token.get_type() )
+        {
+            case TokenType::Null:
+                return ColumnType::Null;
+            case TokenType::Boolean:
+                return ColumnType::Boolean;
+            case TokenType::String:
+                return ColumnType::String;
+            case TokenType::Integer:
+            {
+                std::string const lexeme = token.get_lexeme().to_string();
+                std::int64_t value = 0;
+                auto result = std::from_chars( lexeme.data(), lexeme.data() + lexeme.size(), value );
+                bool const integral = result.ec == std::errc{} && result.ptr == lexeme.data() + lexeme.size();
+                return integral ? ColumnType::Integer : ColumnType::Double;
+            }
+            default:
+                throw JErrorMessages::InvalidToken { "Columnar mode only supports scalar members, found '" +
+                                                        token.get_lexeme().to_string() + "'" };
+        }
+    }
+
+    inline ColumnType ColumnarParser::merge_types( ColumnType a, ColumnType b )
+    {
+        if( a == b || b == ColumnType::Null ){
+            return a;
+        }
+        if( a == ColumnType::Null ){
+            return b;
+        }
+        if( ( a == ColumnType::Integer && b == ColumnType::Double ) || ( a == ColumnType::Double && b == ColumnType::Integer ) ){
+            return ColumnType::Double;
+        }
+        return ColumnType::String;
+    }
+}
+
+#endif // COLUMNAR_TABLE_H_INCLUDED
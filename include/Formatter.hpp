@@ -0,0 +1,355 @@
+#ifndef FORMATTER_H_INCLUDED
+#define FORMATTER_H_INCLUDED
+
+#include <ostream>
+#include <vector>
+#include "Lexer.hpp"
+
+#if defined( __SSE2__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define JPARSER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace JsonParser
+{
+    inline namespace Formatting
+    {
+        struct FormatOptions
+        {
+            bool pretty = false;
+            std::size_t indent = 4;
+            bool validate = true;
+        };
+
+        struct OutputBuffer
+        {
+        private:
+            std::ostream & out;
+            std::vector< char > buffer;
+            std::size_t used;
+        public:
+            explicit OutputBuffer( std::ostream & os, std::size_t size = InputSource::default_chunk_size ):
+                out( os ),
+                buffer( size ),
+                used{ 0 }
+            {
+            }
+
+            OutputBuffer( OutputBuffer const & ) = delete;
+            OutputBuffer& operator=( OutputBuffer const & ) = delete;
+
+            ~OutputBuffer()
+            {
+                flush();
+            }
+
+            void put( char ch )
+            {
+                if( used == buffer.size() ){
+                    flush();
+                }
+                buffer[ used++ ] = ch;
+            }
+
+            void write( char const * data, std::size_t length )
+            {
+                if( length > buffer.size() - used ){
+                    flush();
+                    if( length >= buffer.size() ){
+                        out.write( data, length );
+                        return;
+                    }
+                }
+                memcpy( buffer.data() + used, data, length );
+                used += length;
+            }
+
+            void flush()
+            {
+                out.write( buffer.data(), used );
+                used = 0;
+            }
+        };
+
+        // Finds the next byte the minifier has to look at: a quote or backslash inside
+        // a string, a quote or a byte <= ' ' (whitespace candidate) outside of one.
+        inline char const * find_minify_stop( char const * p, char const * end, bool in_string )
+        {
+#ifdef JPARSER_HAVE_SSE2
+            __m128i const quote = _mm_set1_epi8( '"' );
+            __m128i const backslash = _mm_set1_epi8( '\\' );
+            __m128i const space = _mm_set1_epi8( ' ' );
+
+            for( ; end - p >= 16; p += 16 ){
+                __m128i const block = _mm_loadu_si128( reinterpret_cast< __m128i const * >( p ) );
+                __m128i const quotes = _mm_cmpeq_epi8( block, quote );
+                __m128i const others = in_string ? _mm_cmpeq_epi8( block, backslash )
+                                                 : _mm_cmpeq_epi8( _mm_min_epu8( block, space ), block );
+                int const mask = _mm_movemask_epi8( _mm_or_si128( quotes, others ) );
+                if( mask != 0 ){
+                    return p + __builtin_ctz( mask );
+                }
+            }
+#endif
+            for( ; p != end; ++p ){
+                unsigned char const ch = static_cast< unsigned char >( *p );
+                if( ch == '"' || ( in_string ? ch == '\\' : ch <= ' ' ) ){
+                    return p;
+                }
+            }
+            return end;
+        }
+
+        // Strips insignificant whitespace without tokenizing or validating the input.
+        inline void minify_unchecked( InputSource & source, OutputBuffer & out )
+        {
+            bool in_string = false, escaped = false;
+            char const *chunk = nullptr;
+            std::size_t length = 0;
+
+            while( source.next_chunk( chunk, length ) ){
+                char const *p = chunk, *end = chunk + length;
+                if( escaped && p != end ){
+                    out.put( *p++ );
+                    escaped = false;
+                }
+                while( p != end ){
+                    char const *stop = find_minify_stop( p, end, in_string );
+                    out.write( p, stop - p );
+                    if( stop == end ){
+                        break;
+                    }
+                    char const ch = *stop;
+                    p = stop + 1;
+
+                    if( in_string ){
+                        out.put( ch );
+                        if( ch == '"' ){
+                            in_string = false;
+                        } else if( p == end ){
+                            escaped = true;
+                        } else {
+                            out.put( *p++ );
+                        }
+                    } else if( ch == '"' ){
+                        out.put( ch );
+                        in_string = true;
+                    } else if( ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r' ){
+                        out.put( ch );
+                    }
+                }
+            }
+        }
+
+        // Re-emits the Lexer token stream, minified or indented, in one pass and with
+        // memory bounded by the nesting depth and the longest token; no tree is built.
+        struct StreamFormatter
+        {
+        public:
+            StreamFormatter( std::unique_ptr< InputSource > source, std::ostream & os, FormatOptions const & format_options );
+            void run();
+        private:
+            enum class Expect
+            {
+                Value,
+                FirstValue,
+                Key,
+                FirstKey,
+                Colon,
+                CommaOrClose,
+                End
+            };
+
+            inline void check( Token const & );
+            inline void value_done();
+            inline void emit( Token const & );
+            inline void new_line();
+        private:
+            Lexer lexer;
+            OutputBuffer out;
+            FormatOptions options;
+            std::vector< TokenType > containers;
+            Expect expect;
+            std::size_t depth;
+            bool pending_open;
+        };
+
+        inline StreamFormatter::StreamFormatter( std::unique_ptr< InputSource > source, std::ostream & os, FormatOptions const & format_options ):
+            lexer{ std::move( source ) },
+            out{ os },
+            options{ format_options },
+            containers{},
+            expect{ Expect::Value },
+            depth{ 0 },
+            pending_open{ false }
+        {
+        }
+
+        inline void StreamFormatter::run()
+        {
+            while( lexer.has_more_tokens() ){
+                Token const token = lexer.get_next_token();
+                if( options.validate ){
+                    check( token );
+                }
+                emit( token );
+            }
+            if( options.validate && expect != Expect::End ){
+                throw JErrorMessages::EndOfString{ "Unexpected end of document" };
+            }
+            if( options.pretty ){
+                out.put( '\n' );
+            }
+            out.flush();
+        }
+
+        inline void StreamFormatter::check( Token const & token )
+        {
+            TokenType const type = token.get_type();
+            bool const is_value = type == TokenType::String || type == TokenType::Integer ||
+                                  type == TokenType::Boolean || type == TokenType::Null;
+
+            switch( expect )
+            {
+                case Expect::FirstValue:
+                    if( type == TokenType::Close_SquareBracket ){
+                        containers.pop_back();
+                        value_done();
+                        return;
+                    }
+                    // fall through
+                case Expect::Value:
+                    if( type == TokenType::Open_Braces || type == TokenType::Open_SquareBracket ){
+                        containers.push_back( type );
+                        expect = type == TokenType::Open_Braces ? Expect::FirstKey : Expect::FirstValue;
+                        return;
+                    }
+                    if( is_value ){
+                        value_done();
+                        return;
+                    }
+                    break;
+                case Expect::FirstKey:
+                    if( type == TokenType::Close_Braces ){
+                        containers.pop_back();
+                        value_done();
+                        return;
+                    }
+                    // fall through
+                case Expect::Key:
+                    if( type == TokenType::String ){
+                        expect = Expect::Colon;
+                        return;
+                    }
+                    break;
+                case Expect::Colon:
+                    if( type == TokenType::Colon ){
+                        expect = Expect::Value;
+                        return;
+                    }
+                    break;
+                case Expect::CommaOrClose:
+                    if( type == TokenType::Comma ){
+                        expect = containers.back() == TokenType::Open_Braces ? Expect::Key : Expect::Value;
+                        return;
+                    }
+                    if( ( type == TokenType::Close_Braces && containers.back() == TokenType::Open_Braces ) ||
+                        ( type == TokenType::Close_SquareBracket && containers.back() == TokenType::Open_SquareBracket ) )
+                    {
+                        containers.pop_back();
+                        value_done();
+                        return;
+                    }
+                    break;
+                case Expect::End:
+                    break;
+            }
+            throw JErrorMessages::InvalidToken { "Unexpected token '" + token.get_lexeme().to_string() + "'" };
+        }
+
+        inline void StreamFormatter::value_done()
+        {
+            expect = containers.empty() ? Expect::End : Expect::CommaOrClose;
+        }
+
+        inline void StreamFormatter::emit( Token const & token )
+        {
+            StringBuffer const & lexeme = token.get_lexeme();
+
+            switch( token.get_type() )
+            {
+                case TokenType::Close_Braces:
+                case TokenType::Close_SquareBracket:
+                    if( depth != 0 ){
+                        --depth;
+                    }
+                    if( !pending_open ){
+                        new_line();
+                    }
+                    pending_open = false;
+                    out.put( lexeme[ 0 ] );
+                    return;
+                default:
+                    break;
+            }
+
+            if( pending_open ){
+                new_line();
+                pending_open = false;
+            }
+            switch( token.get_type() )
+            {
+                case TokenType::Open_Braces:
+                case TokenType::Open_SquareBracket:
+                    out.put( lexeme[ 0 ] );
+                    ++depth;
+                    pending_open = true;
+                    break;
+                case TokenType::Comma:
+                    out.put( ',' );
+                    new_line();
+                    break;
+                case TokenType::Colon:
+                    out.put( ':' );
+                    if( options.pretty ){
+                        out.put( ' ' );
+                    }
+                    break;
+                case TokenType::String:
+                    out.put( '"' );
+                    out.write( lexeme.data(), lexeme.length() );
+                    out.put( '"' );
+                    break;
+                default:
+                    out.write( lexeme.data(), lexeme.length() );
+                    break;
+            }
+        }
+
+        inline void StreamFormatter::new_line()
+        {
+            if( !options.pretty ){
+                return;
+            }
+            out.put( '\n' );
+            for( std::size_t i = 0; i != depth * options.indent; ++i ){
+                out.put( ' ' );
+            }
+        }
+
+        // Minifies (or, with options.pretty, re-indents) `source` into `os` in a single
+        // streaming pass. Unvalidated minification skips the lexer altogether.
+        inline void format_json( std::unique_ptr< InputSource > source, std::ostream & os, FormatOptions const & options = FormatOptions{} )
+        {
+            if( !options.pretty && !options.validate ){
+                OutputBuffer out{ os };
+                minify_unchecked( *source, out );
+                return;
+            }
+            StreamFormatter formatter { std::move( source ), os, options };
+            formatter.run();
+        }
+    }
+}
+
+#endif // FORMATTER_H_INCLUDED
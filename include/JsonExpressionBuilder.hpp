@@ -3,27 +3,57 @@
 
 #include <fstream>
 #include "Parser.hpp"
+#include "ColumnarTable.hpp"
+#include "Projection.hpp"
+#include "Schema.hpp"
 
 namespace JsonParser
 {
+    struct ParseOptions
+    {
+        // when set, only the members selected by the projection are built
+        Projection const * projection = nullptr;
+        // when set, the document is validated against the schema while it is parsed
+        CompiledSchema const * schema = nullptr;
+        // when set, structurally identical values and subtrees share one node
+        bool share_identical_nodes = false;
+        // deepest nesting of arrays and objects accepted; bounds the recursion
+        std::size_t max_depth = 512;
+    };
+
     struct Parser
     {
     public:
-        Parser( std::string const & json_string );
+        Parser( std::string const & json_string, ParseOptions const & options = ParseOptions{} );
+        Parser( std::unique_ptr< InputSource > source, ParseOptions const & options = ParseOptions{} );
         ~Parser();
+
+        // Non-throwing parse: on failure returns nullptr and fills `error` with a code
+        // and byte offset. Rejecting malformed input takes no exception at all; only
+        // input/allocation failures are caught and reported as error codes.
+        static json_expr_ptr try_parse( std::string const & json_string, ParseError & error,
+                                        ParseOptions const & options = ParseOptions{} ) noexcept;
+        static json_expr_ptr try_parse( std::unique_ptr< InputSource > source, ParseError & error,
+                                        ParseOptions const & options = ParseOptions{} ) noexcept;
     public:
         
-        json_expr_ptr begin() { return root->begin(); }
-        json_expr_ptr end() { return root->end(); }
+        json_expr_ptr_array::iterator begin() { return root_container().begin(); }
+        json_expr_ptr_array::iterator end() { return root_container().end(); }
 
-        const_json_expr_ptr cbegin() const { return root->cbegin(); }
-        const_json_expr_ptr cend() const { return root->cend(); }
+        json_expr_ptr_array::const_iterator cbegin() const { return root_container().cbegin(); }
+        json_expr_ptr_array::const_iterator cend() const { return root_container().cend(); }
 
         json_expr_ptr get_object() { return root; }
         
         std::size_t size() const { return root->size(); }
         bool is_empty();
     private:
+        Parser( std::unique_ptr< InputSource > source, ParseError * error, ParseOptions const & options );
+
+        JsonBinaryExpression & root_container() const { return static_cast< JsonBinaryExpression & >( *root ); }
+        json_expr_ptr shared( json_expr_ptr const & expr ) { return node_table ? node_table->intern( expr ) : expr; }
+        static std::string_view lexeme_of( Token const & tk ) { return tk.get_lexeme().view(); }
+
         inline void program_block_start( json_expr_ptr & );
         inline void statements( json_expr_ptr & );
         inline void other_statements( json_expr_ptr & );
@@ -34,58 +64,131 @@ namespace JsonParser
         inline void array_arguments( json_expr_ptr &, std::string const &name = "" );
         inline void other_array_arguments( json_expr_ptr & );
 
+        inline void skip_value();
+        inline void skip_member();
+
         inline void match( char ch, Token & );    
+        inline void fail( ErrorCode code, char const * message );
     private:
         json_expr_ptr root;
         Token current_token;
         Lexer lexer;
         bool found_empty_file;
-        
+        ParseOptions options;
+        Projection::level_type projection_level;
+        std::unique_ptr< SchemaValidator > validator;
+        std::unique_ptr< NodeTable > node_table;
+        ParseError *error;
+        std::size_t depth;
     };
 
-    Parser::Parser( std::string const & json_string ):
+    inline Parser::Parser( std::string const & json_string, ParseOptions const & parse_options ):
+        Parser{ std::unique_ptr< InputSource >{ new StringSource{ json_string } }, nullptr, parse_options }
+    {
+    }
+
+    inline Parser::Parser( std::unique_ptr< InputSource > source, ParseOptions const & parse_options ):
+        Parser{ std::move( source ), nullptr, parse_options }
+    {
+    }
+
+    inline Parser::Parser( std::unique_ptr< InputSource > source, ParseError * parse_error, ParseOptions const & parse_options ):
         root{ nullptr },
         current_token { ' ', TokenType::Invalid },
-        lexer{ json_string },
-        found_empty_file { false }
+        lexer{ std::move( source ) },
+        found_empty_file { false },
+        options{ parse_options },
+        projection_level{ parse_options.projection ? parse_options.projection->root() : Projection::keep_all },
+        validator{ parse_options.schema ? new SchemaValidator{ *parse_options.schema } : nullptr },
+        node_table{ parse_options.share_identical_nodes ? new NodeTable{} : nullptr },
+        error{ parse_error },
+        depth{ 0 }
     {
+        lexer.set_error_sink( error );
         program_block_start( root );
     }
 
-    Parser::~Parser()
+    inline json_expr_ptr Parser::try_parse( std::string const & json_string, ParseError & error, ParseOptions const & options ) noexcept
+    {
+        try {
+            return try_parse( std::unique_ptr< InputSource >{ new StringSource{ json_string } }, error, options );
+        } catch( std::bad_alloc const & ){
+            error = ParseError{ ErrorCode::OutOfMemory, 0 };
+        }
+        return nullptr;
+    }
+
+    inline json_expr_ptr Parser::try_parse( std::unique_ptr< InputSource > source, ParseError & error, ParseOptions const & options ) noexcept
+    {
+        error = ParseError{};
+        try {
+            Parser parser{ std::move( source ), &error, options };
+            if( !error ){
+                return parser.get_object();
+            }
+        } catch( std::bad_alloc const & ){
+            error = ParseError{ ErrorCode::OutOfMemory, 0 };
+        } catch( std::exception const & ){
+            error = ParseError{ ErrorCode::InputError, 0 };
+        }
+        return nullptr;
+    }
+
+    inline Parser::~Parser()
     {
     }
 
-    void Parser::program_block_start( json_expr_ptr & node )
+    inline void Parser::program_block_start( json_expr_ptr & node )
     {
         current_token = lexer.get_next_token();
         std::string const & node_name = "__ROOT_ELEMENT__";
+        // the root container is the first level of nesting
+        depth = 1;
 
         if( current_token.get_type() == TokenType::Open_Braces ){
             node = make_object( node_name );
+            if( validator && !validator->begin_container( TokenType::Open_Braces ) ){
+                return fail( ErrorCode::SchemaViolation, "" );
+            }
 
             current_token = lexer.get_next_token();
             statements( node );
 
             if( current_token.get_type() != TokenType::Close_Braces ){
-                throw JErrorMessages::InvalidToken { "Invalid Token found at the end of document. Expected a closing braces '}'" };
+                return fail( ErrorCode::ExpectedClose, "Invalid Token found at the end of document. Expected a closing braces '}', found" );
+            }
+            if( validator && !validator->end_container() ){
+                return fail( ErrorCode::SchemaViolation, "" );
             }
         } else if ( current_token.get_type() == TokenType::Open_SquareBracket ){
             node = make_array( node_name );
+            if( validator && !validator->begin_container( TokenType::Open_SquareBracket ) ){
+                return fail( ErrorCode::SchemaViolation, "" );
+            }
             
             current_token = lexer.get_next_token();
             array_arguments( node );
 
             if( current_token.get_type() != TokenType::Close_SquareBracket ){
-                throw JErrorMessages::InvalidToken { "Invalid Token found at the end of document. "
-                                                        "Expected a closing square bracket ']'" };
+                return fail( ErrorCode::ExpectedClose, "Invalid Token found at the end of document. "
+                                                       "Expected a closing square bracket ']', found" );
+            }
+            if( validator && !validator->end_container() ){
+                return fail( ErrorCode::SchemaViolation, "" );
             }
         } else {
-            throw JErrorMessages::InvalidToken { "Invalid Token found. Expected a Json Object at the start of document." };
+            return fail( ErrorCode::ExpectedDocument, "Invalid Token found. Expected a Json Object at the start of document, found" );
+        }
+
+        // Reading on to the end of input rejects trailing content, and lets a decoding
+        // source notice a stream that was cut off after a complete document.
+        if( lexer.has_more_tokens() ){
+            current_token = lexer.get_next_token();
+            return fail( ErrorCode::ExpectedEnd, "Unexpected content after the end of document, found" );
         }
     }
 
-    void Parser::statements( json_expr_ptr & node )
+    inline void Parser::statements( json_expr_ptr & node )
     {
         if( current_token.get_type() == TokenType::Close_Braces ){
             found_empty_file = true;
@@ -94,147 +197,322 @@ namespace JsonParser
         other_statements( node );
     }
 
-    bool Parser::is_empty()
+    inline bool Parser::is_empty()
     {
         return found_empty_file;
     }
     
-    void Parser::other_statements( json_expr_ptr & node )
+    inline void Parser::other_statements( json_expr_ptr & node )
     {
         stmt( node );
         other_statements_helper( node );
     }
 
-    void Parser::other_statements_helper( json_expr_ptr & node )
+    inline void Parser::other_statements_helper( json_expr_ptr & node )
     {
-        if( current_token.get_type() != TokenType::Comma ){
-            return;
+        while( current_token.get_type() == TokenType::Comma ){
+            current_token = lexer.get_next_token();
+            stmt( node );
         }
-        current_token = lexer.get_next_token();
-        stmt( node );
-        other_statements_helper( node );
     }
 
-    void Parser::stmt( json_expr_ptr & node )
+    inline void Parser::stmt( json_expr_ptr & node )
     {
         if( current_token.get_type() != TokenType::String ){
-            throw JErrorMessages::InvalidToken { "Expected a string before '" + current_token.get_lexeme().to_string() + "'" };
+            return fail( ErrorCode::ExpectedKey, "Expected a string before" );
         }
 
-        auto saved_token_name = current_token.get_lexeme().to_string();
+        Projection::level_type const parent_level = projection_level;
+        if( options.projection ){
+            projection_level = options.projection->select( parent_level, lexeme_of( current_token ) );
+        }
+        if( validator ){
+            validator->key( lexeme_of( current_token ) );
+        }
+        auto saved_token_name = projection_level == Projection::skip ? std::string{} : current_token.get_lexeme().to_string();
         current_token = lexer.get_next_token();
         
         if( current_token.get_type() != TokenType::Colon ){
-            throw JErrorMessages::InvalidToken{ "Expected a colon seperator before " + current_token.get_lexeme().to_string() };
+            projection_level = parent_level;
+            return fail( ErrorCode::ExpectedColon, "Expected a colon seperator before" );
         }
-        current_token = lexer.get_next_token();
-        value( node, saved_token_name );
+
+        if( projection_level == Projection::skip ){
+            // the schema still needs the contents of skipped values
+            lexer.set_discard_lexemes( !validator );
+            current_token = lexer.get_next_token();
+            skip_value();
+            lexer.set_discard_lexemes( false );
+        } else {
+            current_token = lexer.get_next_token();
+            value( node, saved_token_name );
+        }
+        projection_level = parent_level;
     }
     
-    void Parser::value( json_expr_ptr & node, std::string const & saved_token_name )
+    inline void Parser::value( json_expr_ptr & node, std::string const & saved_token_name )
     {
         json_expr_ptr value_consumer = nullptr;
         
         switch( current_token.get_type() )
         {
             case TokenType::Null:
-                node->add_element( make_null( saved_token_name, current_token.get_lexeme().to_string() ) );
+            case TokenType::Boolean:
+            case TokenType::String:
+            case TokenType::Integer:
+                if( validator && !validator->scalar( current_token.get_type(), lexeme_of( current_token ) ) ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                break;
+            case TokenType::Open_SquareBracket:
+            case TokenType::Open_Braces:
+                if( ++depth > options.max_depth ){
+                    return fail( ErrorCode::TooDeep, "Document nests too deeply at" );
+                }
+                if( validator && !validator->begin_container( current_token.get_type() ) ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                break;
+            default:
+                break;
+        }
+
+        switch( current_token.get_type() )
+        {
+            case TokenType::Null:
+                node->add_element( shared( make_null( saved_token_name, current_token.get_lexeme().to_string() ) ) );
                 current_token = lexer.get_next_token();
                 break;
             case TokenType::Boolean:
-                node->add_element( make_bool( saved_token_name, current_token.get_lexeme().to_string() ) );
+                node->add_element( shared( make_bool( saved_token_name, current_token.get_lexeme().to_string() ) ) );
                 current_token = lexer.get_next_token();
                 break;
             case TokenType::String:
-                node->add_element( make_string( saved_token_name, current_token.get_lexeme().to_string() ) );
+                node->add_element( shared( make_string( saved_token_name, current_token.get_lexeme().to_string() ) ) );
                 current_token = lexer.get_next_token();
                 break;
             case TokenType::Integer:
-                node->add_element( make_integer( saved_token_name, current_token.get_lexeme().to_string() ) );
+                node->add_element( shared( make_integer( saved_token_name, current_token.get_lexeme().to_string() ) ) );
                 current_token = lexer.get_next_token();
                 break;
             case TokenType::Open_SquareBracket:
                 value_consumer = make_array( saved_token_name );
                 current_token = lexer.get_next_token();
                 array_arguments( value_consumer );
-                node->add_element( value_consumer );
+                node->add_element( shared( value_consumer ) );
                 match( ']', current_token );
+                if( validator && !validator->end_container() ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                --depth;
                 break;
             case TokenType::Open_Braces:
                 value_consumer = make_object( saved_token_name );
                 current_token = lexer.get_next_token();
-                other_statements( value_consumer );
-                node->add_element( value_consumer );
+                if( current_token.get_type() != TokenType::Close_Braces ){
+                    other_statements( value_consumer );
+                }
+                node->add_element( shared( value_consumer ) );
                 match( '}', current_token );
+                if( validator && !validator->end_container() ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                --depth;
+                break;
             default:
-                return;
+                return fail( ErrorCode::ExpectedValue, "Expected a value before" );
         }
     }
 
-    void Parser::array_arguments( json_expr_ptr & node, std::string const &name )
+    inline void Parser::array_arguments( json_expr_ptr & node, std::string const &name )
     {
+        // a ']' right after the '[' is an empty array, not a missing value
+        if( current_token.get_type() == TokenType::Close_SquareBracket ){
+            return;
+        }
         value( node, name );
         other_array_arguments( node );
     }
 
-    void Parser::other_array_arguments( json_expr_ptr & node )
+    inline void Parser::other_array_arguments( json_expr_ptr & node )
     {
-        if( current_token.get_type() == TokenType::Comma ){
+        while( current_token.get_type() == TokenType::Comma ){
             current_token = lexer.get_next_token();
             value( node, "" );
-            other_array_arguments( node );
         }
     }
     
-    void Parser::match( char ch, Token & tk )
+    // Consumes a value that the projection does not select. The syntax is still
+    // checked, but no nodes are built and no string contents are copied.
+    inline void Parser::skip_value()
+    {
+        switch( current_token.get_type() )
+        {
+            case TokenType::Null:
+            case TokenType::Boolean:
+            case TokenType::String:
+            case TokenType::Integer:
+                if( validator && !validator->scalar( current_token.get_type(), lexeme_of( current_token ) ) ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                current_token = lexer.get_next_token();
+                break;
+            case TokenType::Open_SquareBracket:
+                if( ++depth > options.max_depth ){
+                    return fail( ErrorCode::TooDeep, "Document nests too deeply at" );
+                }
+                if( validator && !validator->begin_container( TokenType::Open_SquareBracket ) ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                current_token = lexer.get_next_token();
+                if( current_token.get_type() != TokenType::Close_SquareBracket ){
+                    skip_value();
+                    while( current_token.get_type() == TokenType::Comma ){
+                        current_token = lexer.get_next_token();
+                        skip_value();
+                    }
+                }
+                match( ']', current_token );
+                if( validator && !validator->end_container() ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                --depth;
+                break;
+            case TokenType::Open_Braces:
+                if( ++depth > options.max_depth ){
+                    return fail( ErrorCode::TooDeep, "Document nests too deeply at" );
+                }
+                if( validator && !validator->begin_container( TokenType::Open_Braces ) ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                current_token = lexer.get_next_token();
+                if( current_token.get_type() != TokenType::Close_Braces ){
+                    skip_member();
+                    while( current_token.get_type() == TokenType::Comma ){
+                        current_token = lexer.get_next_token();
+                        skip_member();
+                    }
+                }
+                match( '}', current_token );
+                if( validator && !validator->end_container() ){
+                    return fail( ErrorCode::SchemaViolation, "" );
+                }
+                --depth;
+                break;
+            default:
+                return fail( ErrorCode::ExpectedValue, "Expected a value before" );
+        }
+    }
+
+    inline void Parser::skip_member()
     {
-        if( ch != tk.get_lexeme().to_string()[0] ){
-            throw JErrorMessages::InvalidToken { "Expected a string before '" + current_token.get_lexeme().to_string() + "'" };
+        if( current_token.get_type() != TokenType::String ){
+            return fail( ErrorCode::ExpectedKey, "Expected a string before" );
+        }
+        if( validator ){
+            validator->key( lexeme_of( current_token ) );
+        }
+        current_token = lexer.get_next_token();
+        if( current_token.get_type() != TokenType::Colon ){
+            return fail( ErrorCode::ExpectedColon, "Expected a colon seperator before" );
+        }
+        current_token = lexer.get_next_token();
+        skip_value();
+    }
+
+    inline void Parser::match( char ch, Token & tk )
+    {
+        if( ch != tk.get_lexeme()[0] ){
+            return fail( ErrorCode::ExpectedClose, ch == '}' ? "Expected a '}' before" : "Expected a ']' before" );
         }
         tk = lexer.get_next_token();
     }
 
+    // Throws, unless the parser was started by try_parse(); then the first error is
+    // recorded and the current token is invalidated, which unwinds the descent.
+    inline void Parser::fail( ErrorCode code, char const * message )
+    {
+        if( !error ){
+            if( code == ErrorCode::SchemaViolation ){
+                throw validator->violation();
+            }
+            throw JErrorMessages::InvalidToken { std::string{ message } + " '" + current_token.get_lexeme().to_string() + "'" };
+        }
+        if( !*error ){
+            error->code = code;
+            error->offset = lexer.token_offset();
+        }
+        current_token = Token::invalid();
+    }
+
     struct JsonDocument
     {
         JsonDocument( std::ifstream & file );
         JsonDocument( std::string const & filename );
         ~JsonDocument();
 
-        json_expr_ptr parse();
+        json_expr_ptr parse( ParseOptions const & options = ParseOptions{} );
+        json_expr_ptr try_parse( ParseError & error, ParseOptions const & options = ParseOptions{} ) noexcept;
+        LineColumn location( ParseError const & error );
+        ColumnarTable parse_columnar( std::size_t inference_rows = 64 );
     private:
         std::string m_filename;
         std::unique_ptr< std::ifstream > ptr;
         std::ifstream & m_file;
     };
 
-    json_expr_ptr JsonDocument::parse()
+    // The file is fed to the lexer in chunks, and gzip/zstd compressed files are
+    // decompressed on the fly; neither is ever read into memory as a whole.
+    inline json_expr_ptr JsonDocument::parse( ParseOptions const & options )
     {
-        std::string json_string{};
-
-        if( m_file ){
-            std::string lines{};
-            while( std::getline( m_file, lines ) ){
-                json_string += lines;
-            }
-        }
-        Parser parser { json_string };
+        Parser parser { make_input_source( m_file ), options };
         return parser.get_object();
     }
     
-    JsonDocument::JsonDocument( std::ifstream & file ):
+    inline json_expr_ptr JsonDocument::try_parse( ParseError & error, ParseOptions const & options ) noexcept
+    {
+        if( !m_file ){
+            error = ParseError{ ErrorCode::InputError, 0 };
+            return nullptr;
+        }
+        std::unique_ptr< InputSource > source{};
+        try {
+            source = make_input_source( m_file );
+        } catch( std::exception const & ){
+            error = ParseError{ ErrorCode::InputError, 0 };
+            return nullptr;
+        }
+        return Parser::try_parse( std::move( source ), error, options );
+    }
+
+    // Reads the file again up to the error offset to work out its line and column.
+    inline LineColumn JsonDocument::location( ParseError const & error )
+    {
+        m_file.clear();
+        m_file.seekg( 0 );
+        return error.location( *make_input_source( m_file ) );
+    }
+
+    inline ColumnarTable JsonDocument::parse_columnar( std::size_t inference_rows )
+    {
+        ColumnarParser parser { make_input_source( m_file ), inference_rows };
+        return std::move( parser.get_table() );
+    }
+
+    inline JsonDocument::JsonDocument( std::ifstream & file ):
         m_filename {},
         ptr { nullptr },
         m_file ( file )
     {
     }
 
-    JsonDocument::JsonDocument( std::string const & filename ):
+    inline JsonDocument::JsonDocument( std::string const & filename ):
         m_filename{ filename },
-        ptr { new std::ifstream { filename } },
+        ptr { new std::ifstream { filename, std::ios::in | std::ios::binary } },
         m_file ( *ptr )
     {
     }
 
-    JsonDocument::~JsonDocument() = default;
+    inline JsonDocument::~JsonDocument() = default;
 }
 #endif // JSON_EXPRESSION_BUILDER_H_INCLUDED
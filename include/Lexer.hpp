@@ -3,6 +3,8 @@
 
 #include <stdexcept>
 #include "Support/StringBuffer.hpp"
+#include "Support/InputSource.hpp"
+#include "ParseError.hpp"
 #include "Token.hpp"
 
 namespace JsonParser
@@ -18,7 +20,7 @@ namespace JsonParser
         struct Token
         {
             Token( char const &c, TokenType tk ):
-                lexeme( 2 ),
+                lexeme(),
                 type( tk )
             {
                 lexeme.append( c );
@@ -55,9 +57,14 @@ namespace JsonParser
                 return type;
             }
             
-            static inline Token punctuator( char const *buf, TokenType tk )
+            static inline Token punctuator( char ch, TokenType tk )
             {
-                return Token{ buf, tk };
+                return Token{ ch, tk };
+            }
+
+            static inline Token invalid()
+            {
+                return Token{ "", TokenType::Invalid };
             }
             
         private:
@@ -68,70 +75,163 @@ namespace JsonParser
         struct Lexer
         {
         private:
-            StringBuffer strbuf;
+            std::unique_ptr< InputSource > source;
+            char const *chunk;
             std::size_t current_index;
             std::size_t end_of_file;
             char current_character;
+            bool end_reached;
+            bool discard_lexemes;
+            ParseError *error_sink;
+            std::size_t chunk_offset;
+            std::size_t token_start;
             
         public:
             Lexer() = delete;
-            explicit Lexer( char const * json_string ):
-                strbuf{ json_string },
+            explicit Lexer( std::unique_ptr< InputSource > input ):
+                source{ std::move( input ) },
+                chunk { nullptr },
                 current_index { 0 },
-                end_of_file { strbuf.length() },
-                current_character{ }
+                end_of_file { 0 },
+                current_character{ },
+                end_reached{ false },
+                discard_lexemes{ false },
+                error_sink{ nullptr },
+                chunk_offset{ 0 },
+                token_start{ 0 }
             {
                 update_current_token();
             }
 
+            explicit Lexer( char const * json_string ):
+                Lexer { std::string{ json_string } }
+            {
+            }
+
             explicit Lexer( std::string const & json_string ):
-                Lexer { json_string.c_str() }
+                Lexer { std::unique_ptr< InputSource >{ new StringSource{ json_string } } }
             {
             }
         private:
             inline void update_current_token()
             {
                 if( eof() ){
+                    current_character = '\0';
+                    end_reached = true;
                     return;
                 }
                 
-                current_character = strbuf[current_index];
+                current_character = chunk[current_index];
                 ++current_index;
             }
 
+            bool next_chunk()
+            {
+                std::size_t length = 0;
+                while( source->next_chunk( chunk, length ) ){
+                    if( length != 0 ){
+                        chunk_offset += end_of_file;
+                        current_index = 0;
+                        end_of_file = length;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
         public:
             inline bool eof()
             {
-                return current_index >= end_of_file;
+                return current_index >= end_of_file && !next_chunk();
+            }
+
+            // Skips whitespace and tells whether another token follows; false once the
+            // whole input has been consumed.
+            bool has_more_tokens()
+            {
+                while( !end_reached && isspace( static_cast< unsigned char >( current_character ) ) ){
+                    update_current_token();
+                }
+                return !end_reached;
+            }
+
+            // Errors are thrown unless an error sink is set. With one, the first error is
+            // recorded there instead and only Invalid tokens are produced afterwards.
+            void set_error_sink( ParseError * sink )
+            {
+                error_sink = sink;
+            }
+
+            bool failed() const
+            {
+                return error_sink && error_sink->code != ErrorCode::None;
+            }
+
+            Token fail( ErrorCode code, std::size_t at )
+            {
+                if( !error_sink ){
+                    if( code == ErrorCode::UnterminatedString ){
+                        throw EndOfString{ error_message( code ) };
+                    }
+                    throw InvalidToken{ error_message( code ) };
+                }
+                if( !failed() ){
+                    error_sink->code = code;
+                    error_sink->offset = at;
+                }
+                return Token::invalid();
+            }
+
+            // byte offset of the current character, or of the end of input
+            std::size_t offset() const
+            {
+                return end_reached ? chunk_offset + end_of_file : chunk_offset + current_index - 1;
+            }
+
+            // byte offset of the first character of the last token returned
+            std::size_t token_offset() const
+            {
+                return token_start;
+            }
+
+            // While set, string tokens are validated but their contents are not copied;
+            // used by the parser to skip values it is not going to keep.
+            void set_discard_lexemes( bool discard )
+            {
+                discard_lexemes = discard;
             }
 
             Token get_next_token()
             {
+                if( failed() ){
+                    return Token::invalid();
+                }
                 for( ; ; )
                 {
+                    token_start = offset();
                     switch( current_character )
                     {
-                        case ' ': case '\t': case '\n': case '\v': case '\f':
+                        case ' ': case '\t': case '\n': case '\r': case '\v': case '\f':
                             update_current_token();
                             continue;
                         case '{':
                             update_current_token();
-                            return Token::punctuator( "{", TokenType::Open_Braces );
+                            return Token::punctuator( '{', TokenType::Open_Braces );
                         case '}':
                             update_current_token();
-                            return Token::punctuator( "}", TokenType::Close_Braces );
+                            return Token::punctuator( '}', TokenType::Close_Braces );
                         case '[':
                             update_current_token();
-                            return Token::punctuator( "[", TokenType::Open_SquareBracket );
+                            return Token::punctuator( '[', TokenType::Open_SquareBracket );
                         case ']':
                             update_current_token();
-                            return Token::punctuator( "]", TokenType::Close_SquareBracket );
+                            return Token::punctuator( ']', TokenType::Close_SquareBracket );
                         case ':':
                             update_current_token();
-                            return Token::punctuator( ":", TokenType::Colon );
+                            return Token::punctuator( ':', TokenType::Colon );
                         case ',':
                             update_current_token();
-                            return Token::punctuator( ",", TokenType::Comma );
+                            return Token::punctuator( ',', TokenType::Comma );
                         case '"':
                             return extract_string_literals();
                         case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': case '0': case '-':
@@ -142,7 +242,7 @@ namespace JsonParser
                             return extract_null_literals();
                         default:
                             update_current_token();
-                            throw InvalidToken{ "Invalid Token found" };
+                            return fail( ErrorCode::InvalidToken, token_start );
                     }
                 }
             }
@@ -157,7 +257,9 @@ namespace JsonParser
                         update_current_token();
                         break;
                     } else if ( current_character == '\\' ) {
-                        string_extracted.append( current_character );
+                        if( !discard_lexemes ){
+                            string_extracted.append( current_character );
+                        }
                         update_current_token();
                         switch( current_character ) {
                             case '\"':
@@ -167,41 +269,101 @@ namespace JsonParser
                             case 'n':
                             case 'r':
                             case 't':
+                            case '/':
+                                break;
+                            case 'u':
+                                for( int i = 0; i != 4; ++i ){
+                                    if( !discard_lexemes ){
+                                        string_extracted.append( current_character );
+                                    }
+                                    update_current_token();
+                                    if( !isxdigit( static_cast< unsigned char >( current_character ) ) ){
+                                        return fail( ErrorCode::InvalidEscape, offset() );
+                                    }
+                                }
                                 break;
 
                             default:
-                                JLexer::InvalidToken{ "Invalid Token found" };
-
+                                return fail( ErrorCode::InvalidEscape, offset() );
                         }
                     } else if( eof() ) {
-                        throw EndOfString{ "Expected a \" before the end of string" };
+                        return fail( ErrorCode::UnterminatedString, offset() );
+                    }
+                    if( !discard_lexemes ){
+                        string_extracted.append( current_character );
                     }
-                    string_extracted.append( current_character );
                     update_current_token();
                 }
                 return Token{ std::move( string_extracted ), TokenType::String };
             }
 
+            // Numbers keep the Integer token type, but follow the full JSON grammar:
+            // an optional minus sign, a fraction part and an exponent part.
             Token extract_integer_literals()
             {
                 StringBuffer buf;
 
-                while( isdigit( current_character ) ){
+                if( current_character == '-' ){
+                    buf.append( current_character );
+                    update_current_token();
+                }
+                if( current_character == '0' ){
+                    // no leading zeros in the integer part
+                    buf.append( current_character );
+                    update_current_token();
+                    if( is_digit( current_character ) ){
+                        return fail( ErrorCode::InvalidNumber, offset() );
+                    }
+                } else if( !extract_digits( buf ) ){
+                    return fail( ErrorCode::InvalidNumber, offset() );
+                }
+                if( current_character == '.' ){
+                    buf.append( current_character );
+                    update_current_token();
+                    if( !extract_digits( buf ) ){
+                        return fail( ErrorCode::InvalidNumber, offset() );
+                    }
+                }
+                if( current_character == 'e' || current_character == 'E' ){
                     buf.append( current_character );
                     update_current_token();
+                    if( current_character == '+' || current_character == '-' ){
+                        buf.append( current_character );
+                        update_current_token();
+                    }
+                    if( !extract_digits( buf ) ){
+                        return fail( ErrorCode::InvalidNumber, offset() );
+                    }
                 }
                 
                 return Token { std::move( buf ), TokenType::Integer };
             }
 
+            static bool is_digit( char ch )
+            {
+                return isdigit( static_cast< unsigned char >( ch ) );
+            }
+
+            bool extract_digits( StringBuffer & buf )
+            {
+                if( !is_digit( current_character ) ){
+                    return false;
+                }
+                while( is_digit( current_character ) ){
+                    buf.append( current_character );
+                    update_current_token();
+                }
+                return true;
+            }
+
             Token extract_null_literals()
             {
                 char const * null_value = "null";
-                StringBuffer buf( 5 );
+                StringBuffer buf;
                 
                 for( int i = 0; i != 4; ++i ){
                     if( current_character != null_value[ i ] ){
-                        throw JErrorMessages::InvalidToken{ "Invalid Token found" };
+                        return fail( ErrorCode::InvalidLiteral, offset() );
                     }
                     buf.append( current_character );
                     update_current_token();
@@ -211,27 +373,17 @@ namespace JsonParser
             
             Token extract_boolean_literals()
             {
-                char const *true_bool = "true", *false_bool = "false";
-                std::size_t const true_bool_length = 4, false_bool_length = 5;
-                
-                if( current_character == 't' ){
-                    if( memcmp( strbuf.data + current_index - 1, true_bool, true_bool_length ) == 0 ){
-                        current_index += ( true_bool_length - 1 );
-                        update_current_token();
-                        return Token{ true_bool, TokenType::Boolean };
-                    } else {
-                        throw JErrorMessages::InvalidToken{ "Invalid Token found" };
-                    }
-                } else if ( current_character == 'f' ){
-                    if( memcmp( strbuf.data + current_index - 1, false_bool, false_bool_length ) == 0 ){
-                        current_index += ( false_bool_length - 1 );
-                        update_current_token();
-                        return Token{ false_bool, TokenType::Boolean };
-                    } else {
-                        throw JErrorMessages::InvalidToken {"Invalid Token found" };
+                char const *literal = current_character == 't' ? "true" : "false";
+                StringBuffer buf;
+
+                for( char const *ch = literal; *ch != '\0'; ++ch ){
+                    if( current_character != *ch ){
+                        return fail( ErrorCode::InvalidLiteral, offset() );
                     }
+                    buf.append( current_character );
+                    update_current_token();
                 }
-                return Token { "", TokenType::Invalid };
+                return Token{ std::move( buf ), TokenType::Boolean };
             }
         };
     }
@@ -0,0 +1,109 @@
+#ifndef PARSE_ERROR_H_INCLUDED
+#define PARSE_ERROR_H_INCLUDED
+
+#include <cstdint>
+#include <string_view>
+#include "Support/InputSource.hpp"
+
+namespace JsonParser
+{
+    enum class ErrorCode: std::uint8_t
+    {
+        None = 0,
+        InvalidToken,
+        InvalidNumber,
+        InvalidLiteral,
+        InvalidEscape,
+        UnterminatedString,
+        ExpectedDocument,
+        ExpectedKey,
+        ExpectedColon,
+        ExpectedValue,
+        ExpectedClose,
+        ExpectedEnd,
+        TooDeep,
+        SchemaViolation,
+        InputError,
+        OutOfMemory
+    };
+
+    inline char const * error_message( ErrorCode code )
+    {
+        switch( code )
+        {
+            case ErrorCode::None: return "No error";
+            case ErrorCode::InvalidToken: return "Invalid Token found";
+            case ErrorCode::InvalidNumber: return "Invalid number";
+            case ErrorCode::InvalidLiteral: return "Invalid literal, expected true, false or null";
+            case ErrorCode::InvalidEscape: return "Invalid escape sequence in string";
+            case ErrorCode::UnterminatedString: return "Expected a \" before the end of string";
+            case ErrorCode::ExpectedDocument: return "Expected a Json Object at the start of document";
+            case ErrorCode::ExpectedKey: return "Expected a string";
+            case ErrorCode::ExpectedColon: return "Expected a colon seperator";
+            case ErrorCode::ExpectedValue: return "Expected a value";
+            case ErrorCode::ExpectedClose: return "Expected a closing brace or bracket";
+            case ErrorCode::ExpectedEnd: return "Unexpected content after the end of document";
+            case ErrorCode::TooDeep: return "Document nests arrays and objects too deeply";
+            case ErrorCode::SchemaViolation: return "Document does not match the schema";
+            case ErrorCode::InputError: return "Unable to read the input";
+            case ErrorCode::OutOfMemory: return "Out of memory";
+        }
+        return "Unknown error";
+    }
+
+    struct LineColumn
+    {
+        std::size_t line;
+        std::size_t column;
+    };
+
+    // What the non-throwing parse path reports: an error code and the byte offset
+    // (into the decompressed input) where it was detected. Line and column are only
+    // worked out on request, by scanning the input again up to that offset.
+    struct ParseError
+    {
+        ErrorCode code = ErrorCode::None;
+        std::size_t offset = 0;
+
+        explicit operator bool() const { return code != ErrorCode::None; }
+        char const * message() const { return error_message( code ); }
+
+        LineColumn location( std::string_view input ) const
+        {
+            LineColumn result{ 1, 1 };
+            std::size_t const end = offset < input.size() ? offset : input.size();
+            for( std::size_t i = 0; i != end; ++i ){
+                advance( result, input[ i ] );
+            }
+            return result;
+        }
+
+        LineColumn location( InputSource & input ) const
+        {
+            LineColumn result{ 1, 1 };
+            std::size_t remaining = offset;
+            char const *chunk = nullptr;
+            std::size_t length = 0;
+            while( remaining != 0 && input.next_chunk( chunk, length ) ){
+                std::size_t const count = length < remaining ? length : remaining;
+                for( std::size_t i = 0; i != count; ++i ){
+                    advance( result, chunk[ i ] );
+                }
+                remaining -= count;
+            }
+            return result;
+        }
+    private:
+        static void advance( LineColumn & location, char ch )
+        {
+            if( ch == '\n' ){
+                ++location.line;
+                location.column = 1;
+            } else {
+                ++location.column;
+            }
+        }
+    };
+}
+
+#endif // PARSE_ERROR_H_INCLUDED
@@ -1,12 +1,19 @@
 #ifndef PARSER_H_INCLUDED
 #define PARSER_H_INCLUDED
 
+#include <functional>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 #include "Lexer.hpp"
 
 namespace JsonParser
 {
+    inline std::size_t hash_combine( std::size_t seed, std::size_t value )
+    {
+        return seed ^ ( value + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 ) );
+    }
+
     class JsonExpression
     {
     public:
@@ -20,6 +27,15 @@ namespace JsonParser
         virtual std::size_t size() const = 0;
         virtual json_expr_ptr& operator []( std::size_t ) = 0;
 
+        // Structural hash and equality: type, key and value or children. A node can
+        // still change through add_element() or operator[], so its hash is computed on
+        // every call; only freeze() caches it, for the node and its whole subtree, which
+        // must not be modified afterwards. NodeTable::intern() freezes what it stores.
+        virtual std::size_t hash() const = 0;
+        virtual bool equals( JsonExpression const & ) const = 0;
+        virtual void freeze() = 0;
+        virtual bool is_frozen() const = 0;
+
         virtual bool isNull() const = 0;
         virtual bool isBoolean() const = 0;
         virtual bool isInteger() const = 0;
@@ -37,6 +53,8 @@ namespace JsonParser
     protected:
         std::string m_key;
         std::string m_value;
+        // nonzero once frozen
+        std::size_t m_hash = 0;
     public:
         JsonTerminalExpression( ): m_key { }, m_value { } {}
         JsonTerminalExpression( std::string const & key, std::string const & value ): m_key { key }, m_value{ value } { }
@@ -48,6 +66,30 @@ namespace JsonParser
         virtual std::string get_value() { return m_value; }
         virtual json_expr_ptr& operator []( std::size_t i ) { return dynamic_cast< json_expr_ptr &>( *this ); }
 
+        virtual std::size_t hash() const override
+        {
+            if( m_hash != 0 ){
+                return m_hash;
+            }
+            std::size_t const type = static_cast< std::size_t >( get_type() );
+            return hash_combine( hash_combine( type, std::hash< std::string >{}( m_key ) ), std::hash< std::string >{}( m_value ) ) | 1;
+        }
+
+        virtual void freeze() override { m_hash = hash(); }
+        virtual bool is_frozen() const override { return m_hash != 0; }
+
+        virtual bool equals( JsonExpression const & other ) const override
+        {
+            if( this == &other ){
+                return true;
+            }
+            if( get_type() != other.get_type() || ( is_frozen() && other.is_frozen() && hash() != other.hash() ) ){
+                return false;
+            }
+            auto const & terminal = static_cast< JsonTerminalExpression const & >( other );
+            return m_key == terminal.m_key && m_value == terminal.m_value;
+        }
+
         virtual bool isArray() const { return false; }
         virtual bool isObject() const { return false; }
     };
@@ -56,6 +98,8 @@ namespace JsonParser
     {
     protected:
         std::pair< std::string, json_expr_ptr_array > child;
+        // nonzero once frozen
+        std::size_t m_hash = 0;
     public:
         typedef json_expr_ptr_array::size_type size_type;
 
@@ -75,6 +119,53 @@ namespace JsonParser
         
         virtual std::size_t size() const { return child.second.size(); }
 
+        virtual std::size_t hash() const override
+        {
+            if( m_hash != 0 ){
+                return m_hash;
+            }
+            std::size_t seed = hash_combine( static_cast< std::size_t >( get_type() ), std::hash< std::string >{}( child.first ) );
+            for( auto const & element: child.second ){
+                seed = hash_combine( seed, element->hash() );
+            }
+            return seed | 1;
+        }
+
+        virtual void freeze() override
+        {
+            if( is_frozen() ){
+                return;
+            }
+            for( auto const & element: child.second ){
+                element->freeze();
+            }
+            m_hash = hash();
+        }
+
+        virtual bool is_frozen() const override { return m_hash != 0; }
+
+        virtual bool equals( JsonExpression const & other ) const override
+        {
+            if( this == &other ){
+                return true;
+            }
+            if( get_type() != other.get_type() || ( is_frozen() && other.is_frozen() && hash() != other.hash() ) ){
+                return false;
+            }
+            auto const & binary = static_cast< JsonBinaryExpression const & >( other );
+            if( child.first != binary.child.first || child.second.size() != binary.child.second.size() ){
+                return false;
+            }
+            for( size_type i = 0; i != child.second.size(); ++i ){
+                json_expr_ptr const & a = child.second[ i ];
+                json_expr_ptr const & b = binary.child.second[ i ];
+                if( a != b && !a->equals( *b ) ){
+                    return false;
+                }
+            }
+            return true;
+        }
+
         virtual bool isNull() const override { return false; }
         virtual bool isBoolean() const override { return false; }
         virtual bool isInteger() const override { return false; }
@@ -151,14 +242,42 @@ namespace JsonParser
         virtual bool isString() const override { return false; }
     };
 
+    struct JsonExpressionHash
+    {
+        std::size_t operator()( const_json_expr_ptr const & expr ) const { return expr->hash(); }
+    };
+
+    struct JsonExpressionEqual
+    {
+        bool operator()( const_json_expr_ptr const & a, const_json_expr_ptr const & b ) const { return a == b || a->equals( *b ); }
+    };
+
+    // Hash-consing table: hands back an already interned node that is structurally
+    // equal to the one given, so identical values and subtrees of a document share a
+    // single node. Interned nodes are frozen; they have several parents and must not
+    // be modified.
+    struct NodeTable
+    {
+    public:
+        json_expr_ptr intern( json_expr_ptr const & expr )
+        {
+            expr->freeze();
+            return *nodes.insert( expr ).first;
+        }
+
+        std::size_t size() const { return nodes.size(); }
+    private:
+        std::unordered_set< json_expr_ptr, JsonExpressionHash, JsonExpressionEqual > nodes;
+    };
+
     inline namespace HelperFunctions
     {
-        json_expr_ptr   make_object( std::string const & name ) { return std::make_shared< JObject > ( name ); }
-        json_expr_ptr   make_array ( std::string const & name ) { return std::make_shared< JArray > ( name ); }
-        json_expr_ptr   make_string( std::string const & key, std::string const & value ) { return std::make_shared< JString > ( key, value ); }
-        json_expr_ptr   make_integer( std::string const & name, std::string const & c ) { return std::make_shared< JInteger > ( name, c ); }
-        json_expr_ptr   make_bool( std::string const & name, std::string const &value ) { return std::make_shared< JBoolean > ( name, value ); }
-        json_expr_ptr   make_null( std::string const & name, std::string const & value ) { return std::make_shared< JNull > ( name, value ); }
+        inline json_expr_ptr make_object( std::string const & name ) { return std::make_shared< JObject > ( name ); }
+        inline json_expr_ptr make_array ( std::string const & name ) { return std::make_shared< JArray > ( name ); }
+        inline json_expr_ptr make_string( std::string const & key, std::string const & value ) { return std::make_shared< JString > ( key, value ); }
+        inline json_expr_ptr make_integer( std::string const & name, std::string const & c ) { return std::make_shared< JInteger > ( name, c ); }
+        inline json_expr_ptr make_bool( std::string const & name, std::string const &value ) { return std::make_shared< JBoolean > ( name, value ); }
+        inline json_expr_ptr make_null( std::string const & name, std::string const & value ) { return std::make_shared< JNull > ( name, value ); }
     }
 }
 
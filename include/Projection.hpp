@@ -0,0 +1,90 @@
+#ifndef PROJECTION_H_INCLUDED
+#define PROJECTION_H_INCLUDED
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JsonParser
+{
+    // A set of key paths to keep while parsing, e.g. { "email", "address.country" }.
+    // Path segments are separated by '.', and arrays are transparent: "email" selects
+    // the "email" member of every object in a top-level array of records. Selecting
+    // a key keeps its whole subtree; every member not on a path is skipped.
+    struct Projection
+    {
+    public:
+        typedef std::size_t level_type;
+
+        static constexpr level_type keep_all = static_cast< level_type >( -1 );
+        static constexpr level_type skip = static_cast< level_type >( -2 );
+
+        Projection(): nodes( 1 ) {}
+        Projection( std::initializer_list< std::string > paths ): Projection()
+        {
+            for( auto const & path: paths ){
+                add_path( path );
+            }
+        }
+        explicit Projection( std::vector< std::string > const & paths ): Projection()
+        {
+            for( auto const & path: paths ){
+                add_path( path );
+            }
+        }
+
+        void add_path( std::string const & path )
+        {
+            level_type level = root();
+            std::string::size_type start = 0;
+
+            for( ; ; ){
+                std::string::size_type const dot = path.find( '.', start );
+                std::string const key = path.substr( start, dot == std::string::npos ? std::string::npos : dot - start );
+                if( nodes[ level ].keep_all ){
+                    return;
+                }
+
+                auto iter = nodes[ level ].children.find( key );
+                if( iter == nodes[ level ].children.end() ){
+                    iter = nodes[ level ].children.emplace( key, nodes.size() ).first;
+                    nodes.emplace_back();
+                }
+                level = iter->second;
+                if( dot == std::string::npos ){
+                    break;
+                }
+                start = dot + 1;
+            }
+            nodes[ level ].keep_all = true;
+            nodes[ level ].children.clear();
+        }
+
+        level_type root() const { return 0; }
+
+        // The level to parse the value of member `key` with, given the level of the
+        // object it belongs to: keep_all, skip, or a level with further selections.
+        level_type select( level_type level, std::string_view key ) const
+        {
+            if( level == keep_all ){
+                return keep_all;
+            }
+            auto iter = nodes[ level ].children.find( key );
+            if( iter == nodes[ level ].children.end() ){
+                return skip;
+            }
+            return nodes[ iter->second ].keep_all ? keep_all : iter->second;
+        }
+    private:
+        struct Node
+        {
+            std::map< std::string, level_type, std::less<> > children;
+            bool keep_all = false;
+        };
+        std::vector< Node > nodes;
+    };
+}
+
+#endif // PROJECTION_H_INCLUDED
@@ -0,0 +1,372 @@
+#ifndef SCHEMA_H_INCLUDED
+#define SCHEMA_H_INCLUDED
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Parser.hpp"
+
+namespace JsonParser
+{
+    struct SchemaError: virtual std::runtime_error { SchemaError( std::string const & err ): std::runtime_error( err ){} };
+
+    struct SchemaViolation: virtual std::runtime_error
+    {
+        SchemaViolation( std::string const & path, std::string const & err ):
+            std::runtime_error( "Schema violation at '" + path + "': " + err ),
+            m_path{ path }
+        {
+        }
+        std::string const & path() const { return m_path; }
+    private:
+        std::string m_path;
+    };
+
+    inline namespace JSchema
+    {
+        enum SchemaType: unsigned
+        {
+            Schema_Object = 1u << 0,
+            Schema_Array = 1u << 1,
+            Schema_String = 1u << 2,
+            Schema_Integer = 1u << 3,
+            Schema_Number = 1u << 4,
+            Schema_Boolean = 1u << 5,
+            Schema_Null = 1u << 6,
+            Schema_Any = ( 1u << 7 ) - 1
+        };
+
+        // One state of a compiled schema; child schemas refer to each other by index.
+        struct SchemaNode
+        {
+            static constexpr std::size_t none = static_cast< std::size_t >( -1 );
+
+            unsigned types = Schema_Any;
+            std::vector< std::pair< std::string, std::size_t > > properties;    // sorted by key
+            std::vector< std::string > required;
+            std::size_t items = none;
+            std::vector< std::pair< unsigned, std::string > > enumeration;
+            bool has_minimum = false, has_maximum = false;
+            double minimum = 0.0, maximum = 0.0;
+            std::size_t min_length = 0, max_length = none;
+        };
+
+        // Compiles the supported JSON Schema subset (type, properties, required, items,
+        // enum, minimum, maximum, minLength, maxLength) into a flat table of SchemaNodes
+        // that SchemaValidator walks while the document is being lexed. Other keywords
+        // are ignored.
+        struct CompiledSchema
+        {
+        public:
+            explicit CompiledSchema( json_expr_ptr schema );
+
+            SchemaNode const & operator []( std::size_t i ) const { return nodes[ i ]; }
+            std::size_t root() const { return 0; }
+
+            static unsigned value_type( TokenType type, std::string_view lexeme );
+        private:
+            std::size_t compile( json_expr_ptr const & schema );
+            static unsigned type_named( std::string const & name );
+        private:
+            std::vector< SchemaNode > nodes;
+        };
+
+        inline unsigned CompiledSchema::value_type( TokenType type, std::string_view lexeme )
+        {
+            switch( type )
+            {
+                case TokenType::Open_Braces: return Schema_Object;
+                case TokenType::Open_SquareBracket: return Schema_Array;
+                case TokenType::String: return Schema_String;
+                case TokenType::Boolean: return Schema_Boolean;
+                case TokenType::Null: return Schema_Null;
+                case TokenType::Integer:
+                    return lexeme.find_first_of( ".eE" ) == std::string_view::npos ? Schema_Integer : Schema_Number;
+                default:
+                    return 0;
+            }
+        }
+
+        inline unsigned CompiledSchema::type_named( std::string const & name )
+        {
+            if( name == "object" ) return Schema_Object;
+            if( name == "array" ) return Schema_Array;
+            if( name == "string" ) return Schema_String;
+            if( name == "integer" ) return Schema_Integer;
+            if( name == "number" ) return Schema_Number | Schema_Integer;
+            if( name == "boolean" ) return Schema_Boolean;
+            if( name == "null" ) return Schema_Null;
+            throw SchemaError{ "Unknown type '" + name + "' in schema" };
+        }
+
+        inline CompiledSchema::CompiledSchema( json_expr_ptr schema ): nodes{}
+        {
+            compile( schema );
+        }
+
+        inline std::size_t CompiledSchema::compile( json_expr_ptr const & schema )
+        {
+            if( !schema || !schema->isObject() ){
+                throw SchemaError{ "A schema must be a Json Object" };
+            }
+            std::size_t const index = nodes.size();
+            nodes.emplace_back();
+
+            for( std::size_t i = 0; i != schema->size(); ++i ){
+                json_expr_ptr keyword = ( *schema )[ i ];
+                std::string const name = keyword->get_key();
+
+                if( name == "type" ){
+                    unsigned types = 0;
+                    if( keyword->isArray() ){
+                        for( std::size_t j = 0; j != keyword->size(); ++j ){
+                            types |= type_named( ( *keyword )[ j ]->get_value() );
+                        }
+                    } else {
+                        types = type_named( keyword->get_value() );
+                    }
+                    nodes[ index ].types = types;
+                } else if( name == "properties" ){
+                    if( !keyword->isObject() ){
+                        throw SchemaError{ "'properties' must be a Json Object" };
+                    }
+                    for( std::size_t j = 0; j != keyword->size(); ++j ){
+                        json_expr_ptr property = ( *keyword )[ j ];
+                        std::size_t const child = compile( property );
+                        nodes[ index ].properties.emplace_back( property->get_key(), child );
+                    }
+                    std::sort( nodes[ index ].properties.begin(), nodes[ index ].properties.end() );
+                } else if( name == "required" ){
+                    if( !keyword->isArray() ){
+                        throw SchemaError{ "'required' must be an array" };
+                    }
+                    for( std::size_t j = 0; j != keyword->size(); ++j ){
+                        nodes[ index ].required.push_back( ( *keyword )[ j ]->get_value() );
+                    }
+                } else if( name == "items" ){
+                    std::size_t const child = compile( keyword );
+                    nodes[ index ].items = child;
+                } else if( name == "enum" ){
+                    if( !keyword->isArray() ){
+                        throw SchemaError{ "'enum' must be an array" };
+                    }
+                    for( std::size_t j = 0; j != keyword->size(); ++j ){
+                        json_expr_ptr member = ( *keyword )[ j ];
+                        if( member->isArray() || member->isObject() ){
+                            throw SchemaError{ "Only scalar enum values are supported" };
+                        }
+                        std::string const value = member->get_value();
+                        TokenType const type = member->isString() ? TokenType::String : member->isNull() ? TokenType::Null :
+                                               member->isBoolean() ? TokenType::Boolean : TokenType::Integer;
+                        nodes[ index ].enumeration.emplace_back( value_type( type, value ), value );
+                    }
+                } else if( name == "minimum" ){
+                    nodes[ index ].has_minimum = true;
+                    nodes[ index ].minimum = std::strtod( keyword->get_value().c_str(), nullptr );
+                } else if( name == "maximum" ){
+                    nodes[ index ].has_maximum = true;
+                    nodes[ index ].maximum = std::strtod( keyword->get_value().c_str(), nullptr );
+                } else if( name == "minLength" ){
+                    nodes[ index ].min_length = std::strtoull( keyword->get_value().c_str(), nullptr, 10 );
+                } else if( name == "maxLength" ){
+                    nodes[ index ].max_length = std::strtoull( keyword->get_value().c_str(), nullptr, 10 );
+                }
+            }
+            return index;
+        }
+
+        // Checks a document against a CompiledSchema as the parser reports it, value by
+        // value. A check returns false on the first violation, which then describes the
+        // offending value by its JSON Pointer.
+        struct SchemaValidator
+        {
+        public:
+            explicit SchemaValidator( CompiledSchema const & compiled_schema ):
+                schema( compiled_schema ),
+                frames{},
+                pending_key{},
+                violation_path{},
+                violation_message{}
+            {
+            }
+
+            SchemaViolation violation() const
+            {
+                return SchemaViolation{ violation_path, violation_message };
+            }
+
+            void key( std::string_view name )
+            {
+                pending_key.assign( name.data(), name.size() );
+                Frame & frame = frames.back();
+                if( frame.schema == SchemaNode::none ){
+                    return;
+                }
+                std::vector< std::string > const & required = schema[ frame.schema ].required;
+                for( std::size_t i = 0; i != required.size(); ++i ){
+                    if( required[ i ] == name ){
+                        frame.seen[ i ] = true;
+                    }
+                }
+            }
+
+            bool begin_container( TokenType type )
+            {
+                std::size_t node = SchemaNode::none;
+                if( !enter_value( CompiledSchema::value_type( type, {} ), {}, node ) ){
+                    return false;
+                }
+                Frame frame{ node, type == TokenType::Open_Braces, 0, segment(), {} };
+                if( frame.is_object && node != SchemaNode::none ){
+                    frame.seen.assign( schema[ node ].required.size(), false );
+                }
+                frames.push_back( std::move( frame ) );
+                return true;
+            }
+
+            bool end_container()
+            {
+                Frame const & frame = frames.back();
+                for( std::size_t i = 0; i != frame.seen.size(); ++i ){
+                    if( !frame.seen[ i ] ){
+                        violation_path = path();
+                        violation_message = "missing required property '" + schema[ frame.schema ].required[ i ] + "'";
+                        return false;
+                    }
+                }
+                frames.pop_back();
+                if( !frames.empty() ){
+                    ++frames.back().index;
+                }
+                return true;
+            }
+
+            bool scalar( TokenType type, std::string_view lexeme )
+            {
+                std::size_t node = SchemaNode::none;
+                if( !enter_value( CompiledSchema::value_type( type, lexeme ), lexeme, node ) ){
+                    return false;
+                }
+                if( node != SchemaNode::none && type == TokenType::String ){
+                    std::size_t const length = string_length( lexeme );
+                    if( length < schema[ node ].min_length || length > schema[ node ].max_length ){
+                        return violation( "string length " + std::to_string( length ) + " is out of range" );
+                    }
+                }
+                if( !frames.empty() ){
+                    ++frames.back().index;
+                }
+                return true;
+            }
+        private:
+            struct Frame
+            {
+                std::size_t schema;
+                bool is_object;
+                std::size_t index;
+                std::string segment;
+                std::vector< bool > seen;
+            };
+
+            // Resolves the schema of the value that starts now and checks its type,
+            // enum and range; `lexeme` is empty for containers.
+            bool enter_value( unsigned type, std::string_view lexeme, std::size_t & node )
+            {
+                node = schema.root();
+                if( !frames.empty() ){
+                    Frame const & parent = frames.back();
+                    node = SchemaNode::none;
+                    if( parent.schema != SchemaNode::none ){
+                        SchemaNode const & parent_node = schema[ parent.schema ];
+                        if( parent.is_object ){
+                            auto iter = std::lower_bound( parent_node.properties.begin(), parent_node.properties.end(), pending_key,
+                                                          []( std::pair< std::string, std::size_t > const & p, std::string const & k ){ return p.first < k; } );
+                            if( iter != parent_node.properties.end() && iter->first == pending_key ){
+                                node = iter->second;
+                            }
+                        } else {
+                            node = parent_node.items;
+                        }
+                    }
+                }
+                if( node == SchemaNode::none ){
+                    return true;
+                }
+
+                SchemaNode const & current = schema[ node ];
+                if( ( current.types & type ) == 0 ){
+                    return violation( "value has the wrong type" );
+                }
+                if( !current.enumeration.empty() ){
+                    bool found = false;
+                    for( auto const & allowed: current.enumeration ){
+                        found = found || ( allowed.first == type && allowed.second == lexeme );
+                    }
+                    if( !found ){
+                        return violation( "value is not one of the enumerated values" );
+                    }
+                }
+                if( ( type == Schema_Integer || type == Schema_Number ) && ( current.has_minimum || current.has_maximum ) ){
+                    double const number = std::strtod( std::string{ lexeme }.c_str(), nullptr );
+                    if( ( current.has_minimum && number < current.minimum ) || ( current.has_maximum && number > current.maximum ) ){
+                        return violation( "number is out of range" );
+                    }
+                }
+                return true;
+            }
+
+            // string length in characters: UTF-8 continuation bytes and the characters
+            // of an escape sequence do not count
+            static std::size_t string_length( std::string_view lexeme )
+            {
+                std::size_t length = 0;
+                for( std::size_t i = 0; i < lexeme.size(); ++i ){
+                    if( lexeme[ i ] == '\\' ){
+                        i += ( i + 1 < lexeme.size() && lexeme[ i + 1 ] == 'u' ) ? 5 : 1;
+                    } else if( ( static_cast< unsigned char >( lexeme[ i ] ) & 0xC0 ) == 0x80 ){
+                        continue;
+                    }
+                    ++length;
+                }
+                return length;
+            }
+
+            std::string segment() const
+            {
+                if( frames.empty() ){
+                    return std::string{};
+                }
+                return frames.back().is_object ? pending_key : std::to_string( frames.back().index );
+            }
+
+            std::string path() const
+            {
+                std::string result{};
+                for( std::size_t i = 1; i < frames.size(); ++i ){
+                    result += '/' + frames[ i ].segment;
+                }
+                return result.empty() ? "/" : result;
+            }
+
+            bool violation( std::string const & what )
+            {
+                violation_path = path();
+                if( !frames.empty() ){
+                    violation_path = ( violation_path == "/" ? "" : violation_path ) + '/' + segment();
+                }
+                violation_message = what;
+                return false;
+            }
+        private:
+            CompiledSchema const & schema;
+            std::vector< Frame > frames;
+            std::string pending_key;
+            std::string violation_path;
+            std::string violation_message;
+        };
+    }
+}
+
+#endif // SCHEMA_H_INCLUDED
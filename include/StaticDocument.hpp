@@ -0,0 +1,364 @@
+#ifndef STATIC_DOCUMENT_H_INCLUDED
+#define STATIC_DOCUMENT_H_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include "Lexer.hpp"
+
+namespace JsonParser
+{
+    inline namespace Static
+    {
+        // A node of a StaticDocument. Nodes are laid out in document order, so the
+        // children of node i start at i + 1 and its subtree ends at `subtree_end`.
+        // Keys and values are views into the original literal, escapes left as is.
+        struct StaticNode
+        {
+            JsonType type = JsonType::Null;
+            std::string_view key{};
+            std::string_view value{};
+            std::size_t size = 0;
+            std::size_t subtree_end = 0;
+        };
+
+        // Recursive descent parser that is usable in constant expressions. Run without
+        // a node array it only counts the nodes a document needs. A syntax error, or a
+        // document with more nodes than `node_capacity`, throws; during constant
+        // evaluation that turns into a compile error at the throw.
+        struct StaticParser
+        {
+        public:
+            constexpr StaticParser( std::string_view json, StaticNode *node_array, std::size_t node_capacity = 0 ):
+                text{ json },
+                nodes{ node_array },
+                capacity{ node_capacity },
+                position{ 0 },
+                count{ 0 }
+            {
+            }
+
+            constexpr std::size_t parse()
+            {
+                skip_whitespace();
+                if( peek() != '{' && peek() != '[' ){
+                    throw JErrorMessages::InvalidToken { "Invalid Token found. Expected a Json Object at the start of document." };
+                }
+                value( std::string_view{} );
+                skip_whitespace();
+                if( position != text.size() ){
+                    throw JErrorMessages::InvalidToken { "Invalid Token found at the end of document." };
+                }
+                return count;
+            }
+        private:
+            constexpr char peek() const
+            {
+                return position < text.size() ? text[ position ] : '\0';
+            }
+
+            constexpr void skip_whitespace()
+            {
+                while( peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r' ){
+                    ++position;
+                }
+            }
+
+            constexpr void expect( char ch )
+            {
+                skip_whitespace();
+                if( peek() != ch ){
+                    throw JErrorMessages::InvalidToken { "Invalid Token found" };
+                }
+                ++position;
+            }
+
+            constexpr void value( std::string_view key )
+            {
+                skip_whitespace();
+                if( nodes && count == capacity ){
+                    throw std::length_error{ "Static document has more nodes than it was sized for" };
+                }
+                std::size_t const index = count++;
+                StaticNode node{};
+                node.key = key;
+
+                char const ch = peek();
+                if( ch == '{' ){
+                    node.type = JsonType::Object;
+                    ++position;
+                    skip_whitespace();
+                    if( peek() == '}' ){
+                        ++position;
+                    } else {
+                        for( ; ; ){
+                            skip_whitespace();
+                            std::string_view const member = string_literal();
+                            expect( ':' );
+                            value( member );
+                            ++node.size;
+                            skip_whitespace();
+                            if( peek() != ',' ){
+                                break;
+                            }
+                            ++position;
+                        }
+                        expect( '}' );
+                    }
+                } else if( ch == '[' ){
+                    node.type = JsonType::Array;
+                    ++position;
+                    skip_whitespace();
+                    if( peek() == ']' ){
+                        ++position;
+                    } else {
+                        for( ; ; ){
+                            value( std::string_view{} );
+                            ++node.size;
+                            skip_whitespace();
+                            if( peek() != ',' ){
+                                break;
+                            }
+                            ++position;
+                        }
+                        expect( ']' );
+                    }
+                } else if( ch == '"' ){
+                    node.type = JsonType::String;
+                    node.value = string_literal();
+                } else if( ch == '-' || ( ch >= '0' && ch <= '9' ) ){
+                    node.type = JsonType::Integer;
+                    node.value = number_literal();
+                } else if( ch == 't' || ch == 'f' ){
+                    node.type = JsonType::Boolean;
+                    node.value = keyword( ch == 't' ? "true" : "false" );
+                } else if( ch == 'n' ){
+                    node.type = JsonType::Null;
+                    node.value = keyword( "null" );
+                } else {
+                    throw JErrorMessages::InvalidToken { "Invalid Token found" };
+                }
+
+                node.subtree_end = count;
+                if( nodes ){
+                    nodes[ index ] = node;
+                }
+            }
+
+            constexpr std::string_view string_literal()
+            {
+                if( peek() != '"' ){
+                    throw JErrorMessages::InvalidToken { "Expected a string" };
+                }
+                std::size_t const start = ++position;
+                for( ; ; ){
+                    char const ch = peek();
+                    if( position == text.size() ){
+                        throw JErrorMessages::EndOfString{ "Expected a \" before the end of string" };
+                    } else if( ch == '"' ){
+                        break;
+                    } else if( ch == '\\' ){
+                        ++position;
+                        switch( peek() )
+                        {
+                            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                                break;
+                            case 'u':
+                                for( int i = 0; i != 4; ++i ){
+                                    ++position;
+                                    char const hex = peek();
+                                    if( !( ( hex >= '0' && hex <= '9' ) || ( hex >= 'a' && hex <= 'f' ) || ( hex >= 'A' && hex <= 'F' ) ) ){
+                                        throw JErrorMessages::InvalidToken { "Invalid unicode escape" };
+                                    }
+                                }
+                                break;
+                            default:
+                                throw JErrorMessages::InvalidToken { "Invalid escape sequence" };
+                        }
+                    } else if( static_cast< unsigned char >( ch ) < ' ' ){
+                        throw JErrorMessages::InvalidToken { "Control character in string" };
+                    }
+                    ++position;
+                }
+                return text.substr( start, position++ - start );
+            }
+
+            constexpr std::string_view number_literal()
+            {
+                std::size_t const start = position;
+                if( peek() == '-' ){
+                    ++position;
+                }
+                if( peek() == '0' ){
+                    // no leading zeros in the integer part
+                    ++position;
+                    if( peek() >= '0' && peek() <= '9' ){
+                        throw JErrorMessages::InvalidToken { "Invalid number, leading zero" };
+                    }
+                } else {
+                    digits();
+                }
+                if( peek() == '.' ){
+                    ++position;
+                    digits();
+                }
+                if( peek() == 'e' || peek() == 'E' ){
+                    ++position;
+                    if( peek() == '+' || peek() == '-' ){
+                        ++position;
+                    }
+                    digits();
+                }
+                return text.substr( start, position - start );
+            }
+
+            constexpr void digits()
+            {
+                if( peek() < '0' || peek() > '9' ){
+                    throw JErrorMessages::InvalidToken { "Invalid Token found. Expected a digit" };
+                }
+                while( peek() >= '0' && peek() <= '9' ){
+                    ++position;
+                }
+            }
+
+            constexpr std::string_view keyword( std::string_view word )
+            {
+                if( text.substr( position, word.size() ) != word ){
+                    throw JErrorMessages::InvalidToken { "Invalid Token found" };
+                }
+                position += word.size();
+                return word;
+            }
+        private:
+            std::string_view text;
+            StaticNode *nodes;
+            std::size_t capacity;
+            std::size_t position;
+            std::size_t count;
+        };
+
+        // A read-only view of one node of a StaticDocument; every accessor is constexpr,
+        // so lookups into a constexpr document fold into constants.
+        struct StaticValue
+        {
+        public:
+            constexpr StaticValue( StaticNode const * node_array, std::size_t node_index ): nodes{ node_array }, index{ node_index } {}
+
+            constexpr JsonType get_type() const { return node().type; }
+            constexpr std::string_view get_key() const { return node().key; }
+            constexpr std::string_view get_value() const { return node().value; }
+            constexpr std::size_t size() const { return node().size; }
+
+            constexpr bool isNull() const { return get_type() == JsonType::Null; }
+            constexpr bool isBoolean() const { return get_type() == JsonType::Boolean; }
+            constexpr bool isInteger() const { return get_type() == JsonType::Integer; }
+            constexpr bool isString() const { return get_type() == JsonType::String; }
+            constexpr bool isArray() const { return get_type() == JsonType::Array; }
+            constexpr bool isObject() const { return get_type() == JsonType::Object; }
+
+            constexpr bool contains( std::string_view key ) const
+            {
+                return find( key ) != node().subtree_end;
+            }
+
+            constexpr StaticValue operator []( std::string_view key ) const
+            {
+                std::size_t const child = find( key );
+                if( child == node().subtree_end ){
+                    throw std::out_of_range{ "No such key in static document" };
+                }
+                return StaticValue{ nodes, child };
+            }
+
+            constexpr StaticValue operator []( std::size_t i ) const
+            {
+                if( !isArray() && !isObject() ){
+                    throw std::out_of_range{ "Not a container" };
+                }
+                std::size_t child = index + 1;
+                for( ; i != 0 && child != node().subtree_end; --i ){
+                    child = nodes[ child ].subtree_end;
+                }
+                if( child == node().subtree_end ){
+                    throw std::out_of_range{ "Index out of range in static document" };
+                }
+                return StaticValue{ nodes, child };
+            }
+
+            constexpr bool as_boolean() const
+            {
+                if( !isBoolean() ){
+                    throw std::logic_error{ "Not a boolean" };
+                }
+                return get_value() == "true";
+            }
+
+            constexpr std::int64_t as_integer() const
+            {
+                std::string_view const digits = get_value();
+                if( !isInteger() || digits.find_first_of( ".eE" ) != std::string_view::npos ){
+                    throw std::logic_error{ "Not an integer" };
+                }
+                bool const negative = digits[ 0 ] == '-';
+                std::int64_t result = 0;
+                for( std::size_t i = negative ? 1 : 0; i != digits.size(); ++i ){
+                    result = result * 10 + ( digits[ i ] - '0' );
+                }
+                return negative ? -result : result;
+            }
+        private:
+            constexpr StaticNode const & node() const { return nodes[ index ]; }
+
+            constexpr std::size_t find( std::string_view key ) const
+            {
+                if( !isObject() ){
+                    return node().subtree_end;
+                }
+                std::size_t child = index + 1;
+                while( child != node().subtree_end && nodes[ child ].key != key ){
+                    child = nodes[ child ].subtree_end;
+                }
+                return child;
+            }
+        private:
+            StaticNode const *nodes;
+            std::size_t index;
+        };
+
+        template< std::size_t N >
+        struct StaticDocument
+        {
+            std::array< StaticNode, N > nodes{};
+
+            constexpr StaticValue root() const { return StaticValue{ nodes.data(), 0 }; }
+            constexpr std::size_t size() const { return root().size(); }
+
+            constexpr StaticValue operator []( std::string_view key ) const { return root()[ key ]; }
+            constexpr StaticValue operator []( std::size_t i ) const { return root()[ i ]; }
+        };
+
+        constexpr std::size_t count_static_nodes( std::string_view json )
+        {
+            return StaticParser{ json, nullptr }.parse();
+        }
+
+        template< std::size_t N >
+        constexpr StaticDocument< N > make_static_document( std::string_view json )
+        {
+            StaticDocument< N > document{};
+            StaticParser{ json, document.nodes.data(), N }.parse();
+            return document;
+        }
+    }
+}
+
+// Parses a JSON string literal at compile time into a StaticDocument sized to fit:
+//     constexpr auto flags = JPARSER_STATIC_DOCUMENT( R"({ "beta": true })" );
+//     static_assert( flags[ "beta" ].as_boolean(), "" );
+// The literal must outlive the document (string literals always do).
+#define JPARSER_STATIC_DOCUMENT( json ) \
+    ::JsonParser::make_static_document< ::JsonParser::count_static_nodes( json ) >( json )
+
+#endif // STATIC_DOCUMENT_H_INCLUDED
@@ -0,0 +1,386 @@
+#ifndef INPUT_SOURCE_H_INCLUDED
+#define INPUT_SOURCE_H_INCLUDED
+
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string.h>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define JPARSER_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef JPARSER_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef JPARSER_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace JsonParser
+{
+    inline namespace Support
+    {
+        struct InputSourceError: virtual std::runtime_error { InputSourceError( std::string const & err ): std::runtime_error( err ){} };
+
+        // An InputSource hands the lexer its input one chunk at a time. A chunk stays
+        // valid until the next call to next_chunk(); false means there is nothing left.
+        struct InputSource
+        {
+            static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+            virtual ~InputSource() = default;
+            virtual bool next_chunk( char const *& chunk, std::size_t & length ) = 0;
+        };
+
+        struct StringSource: public InputSource
+        {
+        private:
+            std::string buffer;
+            bool consumed;
+        public:
+            explicit StringSource( std::string str ): buffer{ std::move( str ) }, consumed{ false } {}
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                if( consumed || buffer.empty() ){
+                    return false;
+                }
+                consumed = true;
+                chunk = buffer.data();
+                length = buffer.size();
+                return true;
+            }
+        };
+
+        struct StreamSource: public InputSource
+        {
+        private:
+            std::istream & stream;
+            std::vector< char > buffer;
+        public:
+            explicit StreamSource( std::istream & is, std::size_t chunk_size = default_chunk_size ):
+                stream( is ),
+                buffer( chunk_size )
+            {
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                if( !stream ){
+                    return false;
+                }
+                stream.read( buffer.data(), buffer.size() );
+                length = static_cast< std::size_t >( stream.gcount() );
+                chunk = buffer.data();
+                return length != 0;
+            }
+        };
+
+        struct FileSource: public InputSource
+        {
+        private:
+            std::ifstream file;
+            StreamSource stream;
+        public:
+            explicit FileSource( std::string const & filename ):
+                file{ filename, std::ios::in | std::ios::binary },
+                stream{ file }
+            {
+                if( !file ){
+                    throw InputSourceError{ "Unable to open " + filename };
+                }
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                return stream.next_chunk( chunk, length );
+            }
+        };
+
+#ifdef JPARSER_HAVE_MMAP
+        // Maps the whole file and hands it out as a single chunk; the kernel pages it
+        // in as the lexer walks through it.
+        struct MappedFileSource: public InputSource
+        {
+        private:
+            char const *data;
+            std::size_t size;
+            bool consumed;
+        public:
+            explicit MappedFileSource( std::string const & filename ):
+                data{ nullptr },
+                size{ 0 },
+                consumed{ false }
+            {
+                int const fd = ::open( filename.c_str(), O_RDONLY );
+                if( fd == -1 ){
+                    throw InputSourceError{ "Unable to open " + filename };
+                }
+                struct stat file_status{};
+                if( ::fstat( fd, &file_status ) == -1 ){
+                    ::close( fd );
+                    throw InputSourceError{ "Unable to stat " + filename };
+                }
+                size = static_cast< std::size_t >( file_status.st_size );
+                if( size != 0 ){
+                    void *mapping = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+                    if( mapping == MAP_FAILED ){
+                        ::close( fd );
+                        throw InputSourceError{ "Unable to map " + filename };
+                    }
+                    ::madvise( mapping, size, MADV_SEQUENTIAL );
+                    data = static_cast< char const * >( mapping );
+                }
+                ::close( fd );
+            }
+
+            MappedFileSource( MappedFileSource const & ) = delete;
+            MappedFileSource& operator=( MappedFileSource const & ) = delete;
+
+            ~MappedFileSource()
+            {
+                if( data ){
+                    ::munmap( const_cast< char * >( data ), size );
+                }
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                if( consumed || size == 0 ){
+                    return false;
+                }
+                consumed = true;
+                chunk = data;
+                length = size;
+                return true;
+            }
+        };
+#endif
+
+        // Hands back a chunk already pulled from the wrapped source before carrying on
+        // with the rest of it, so that magic bytes can be sniffed without copying.
+        struct ReplaySource: public InputSource
+        {
+        private:
+            std::unique_ptr< InputSource > source;
+            char const *pending;
+            std::size_t pending_length;
+        public:
+            ReplaySource( std::unique_ptr< InputSource > src, char const * chunk, std::size_t length ):
+                source{ std::move( src ) },
+                pending{ chunk },
+                pending_length{ length }
+            {
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                if( pending ){
+                    chunk = pending;
+                    length = pending_length;
+                    pending = nullptr;
+                    return true;
+                }
+                return source->next_chunk( chunk, length );
+            }
+        };
+
+#ifdef JPARSER_WITH_ZLIB
+        struct GzipSource: public InputSource
+        {
+        private:
+            std::unique_ptr< InputSource > source;
+            std::vector< char > buffer;
+            z_stream zstream;
+            // rest of the current input chunk; inflate takes at most UINT_MAX bytes at once
+            char const *pending;
+            std::size_t pending_length;
+            bool finished;
+            // whether the last member seen so far was decoded up to its trailer
+            bool member_complete;
+        public:
+            explicit GzipSource( std::unique_ptr< InputSource > compressed, std::size_t chunk_size = default_chunk_size ):
+                source{ std::move( compressed ) },
+                buffer( chunk_size ),
+                zstream{},
+                pending{ nullptr },
+                pending_length{ 0 },
+                finished{ false },
+                member_complete{ false }
+            {
+                // 15 + 16: maximum window size, expect a gzip header and trailer
+                if( inflateInit2( &zstream, 15 + 16 ) != Z_OK ){
+                    throw InputSourceError{ "Unable to initialize the gzip decoder" };
+                }
+            }
+
+            GzipSource( GzipSource const & ) = delete;
+            GzipSource& operator=( GzipSource const & ) = delete;
+
+            ~GzipSource()
+            {
+                inflateEnd( &zstream );
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                zstream.next_out = reinterpret_cast< Bytef * >( buffer.data() );
+                zstream.avail_out = static_cast< uInt >( buffer.size() );
+
+                while( !finished && zstream.avail_out != 0 ){
+                    if( zstream.avail_in == 0 ){
+                        if( pending_length == 0 && !source->next_chunk( pending, pending_length ) ){
+                            if( !member_complete ){
+                                throw InputSourceError{ "Truncated gzip stream" };
+                            }
+                            finished = true;
+                            break;
+                        }
+                        std::size_t const slice = std::min< std::size_t >( pending_length, std::numeric_limits< uInt >::max() );
+                        zstream.next_in = reinterpret_cast< Bytef * >( const_cast< char * >( pending ) );
+                        zstream.avail_in = static_cast< uInt >( slice );
+                        pending += slice;
+                        pending_length -= slice;
+                    }
+                    int const status = inflate( &zstream, Z_NO_FLUSH );
+                    member_complete = status == Z_STREAM_END;
+                    if( status == Z_STREAM_END ){
+                        // concatenated gzip members are decoded back to back
+                        inflateReset( &zstream );
+                    } else if( status != Z_OK && status != Z_BUF_ERROR ){
+                        throw InputSourceError{ "Corrupt gzip stream" };
+                    }
+                }
+                length = buffer.size() - zstream.avail_out;
+                chunk = buffer.data();
+                return length != 0;
+            }
+        };
+#endif
+
+#ifdef JPARSER_WITH_ZSTD
+        struct ZstdSource: public InputSource
+        {
+        private:
+            std::unique_ptr< InputSource > source;
+            std::vector< char > buffer;
+            ZSTD_DStream *dstream;
+            ZSTD_inBuffer input;
+            bool finished;
+            // last hint from ZSTD_decompressStream; nonzero while a frame is incomplete
+            std::size_t pending;
+        public:
+            explicit ZstdSource( std::unique_ptr< InputSource > compressed, std::size_t chunk_size = default_chunk_size ):
+                source{ std::move( compressed ) },
+                buffer( chunk_size ),
+                dstream{ ZSTD_createDStream() },
+                input{ nullptr, 0, 0 },
+                finished{ false },
+                pending{ 0 }
+            {
+                if( !dstream || ZSTD_isError( ZSTD_initDStream( dstream ) ) ){
+                    ZSTD_freeDStream( dstream );
+                    throw InputSourceError{ "Unable to initialize the zstd decoder" };
+                }
+            }
+
+            ZstdSource( ZstdSource const & ) = delete;
+            ZstdSource& operator=( ZstdSource const & ) = delete;
+
+            ~ZstdSource()
+            {
+                ZSTD_freeDStream( dstream );
+            }
+
+            bool next_chunk( char const *& chunk, std::size_t & length ) override
+            {
+                ZSTD_outBuffer output{ buffer.data(), buffer.size(), 0 };
+
+                while( !finished && output.pos != output.size ){
+                    if( input.pos == input.size ){
+                        char const *in = nullptr;
+                        std::size_t in_length = 0;
+                        if( !source->next_chunk( in, in_length ) ){
+                            if( pending != 0 ){
+                                throw InputSourceError{ "Truncated zstd stream" };
+                            }
+                            finished = true;
+                            break;
+                        }
+                        input = ZSTD_inBuffer{ in, in_length, 0 };
+                    }
+                    std::size_t const status = ZSTD_decompressStream( dstream, &output, &input );
+                    if( ZSTD_isError( status ) ){
+                        throw InputSourceError{ std::string{ "Corrupt zstd stream: " } + ZSTD_getErrorName( status ) };
+                    }
+                    pending = status;
+                }
+                length = output.pos;
+                chunk = buffer.data();
+                return length != 0;
+            }
+        };
+#endif
+
+        // Peeks at the first chunk of `raw` and, if it starts with a gzip or zstd magic
+        // number, wraps it in the matching streaming decoder.
+        inline std::unique_ptr< InputSource > make_decoding_source( std::unique_ptr< InputSource > raw )
+        {
+            static unsigned char const gzip_magic[] = { 0x1F, 0x8B };
+            static unsigned char const zstd_magic[] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+            char const *chunk = nullptr;
+            std::size_t length = 0;
+            if( !raw->next_chunk( chunk, length ) ){
+                return raw;
+            }
+            std::unique_ptr< InputSource > source{ new ReplaySource{ std::move( raw ), chunk, length } };
+
+            if( length >= sizeof( gzip_magic ) && memcmp( chunk, gzip_magic, sizeof( gzip_magic ) ) == 0 ){
+#ifdef JPARSER_WITH_ZLIB
+                return std::unique_ptr< InputSource >{ new GzipSource{ std::move( source ) } };
+#else
+                throw InputSourceError{ "Input is gzip compressed, but gzip support was not compiled in (JPARSER_WITH_ZLIB)" };
+#endif
+            }
+            if( length >= sizeof( zstd_magic ) && memcmp( chunk, zstd_magic, sizeof( zstd_magic ) ) == 0 ){
+#ifdef JPARSER_WITH_ZSTD
+                return std::unique_ptr< InputSource >{ new ZstdSource{ std::move( source ) } };
+#else
+                throw InputSourceError{ "Input is zstd compressed, but zstd support was not compiled in (JPARSER_WITH_ZSTD)" };
+#endif
+            }
+            return source;
+        }
+
+        inline std::unique_ptr< InputSource > make_input_source( std::istream & stream )
+        {
+            return make_decoding_source( std::unique_ptr< InputSource >{ new StreamSource{ stream } } );
+        }
+
+        // Opens `filename` memory mapped where the platform allows it, read in chunks
+        // otherwise, and decompressed on the fly if needed.
+        inline std::unique_ptr< InputSource > make_file_source( std::string const & filename )
+        {
+#ifdef JPARSER_HAVE_MMAP
+            return make_decoding_source( std::unique_ptr< InputSource >{ new MappedFileSource{ filename } } );
+#else
+            return make_decoding_source( std::unique_ptr< InputSource >{ new FileSource{ filename } } );
+#endif
+        }
+    }
+}
+
+#endif // INPUT_SOURCE_H_INCLUDED
@@ -1,156 +1,213 @@
 #ifndef STRING_BUFFER_H_INCLUDED
 #define STRING_BUFFER_H_INCLUDED
 
-#include <string>
-#include <string.h>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+
+// All heap traffic of StringBuffer goes through these two, so they can be replaced
+// (e.g. to count allocations, see Benchmark/string_buffer.cpp) before inclusion.
+#ifndef JPARSER_REALLOC
+#define JPARSER_REALLOC( ptr, size ) std::realloc( ( ptr ), ( size ) )
+#endif
+#ifndef JPARSER_FREE
+#define JPARSER_FREE( ptr ) std::free( ( ptr ) )
+#endif
 
 namespace JsonParser
 {
     inline namespace Support
     {
+        // Byte buffer for lexemes. Short contents (punctuators, numbers, literals and
+        // most keys) live in the inline storage and never touch the heap; longer ones
+        // move to a heap block that grows geometrically with realloc. Every operation
+        // works on the stored length; the trailing '\0' is kept only for convenience.
         struct StringBuffer
         {
         public:
-            char *data;
-        private:
-            char *current, *end;
-            std::size_t size;
-        public:
-            explicit StringBuffer( std::size_t _size ):
-                data{ static_cast<char *>( calloc ( _size, 1 ) ) },
-                current { data },
-                end{ data + _size },
-                size { _size }
+            static constexpr std::size_t inline_capacity = 23;
+
+            StringBuffer():
+                m_data{ m_inline },
+                m_length{ 0 },
+                m_capacity{ inline_capacity }
             {
+                m_inline[ 0 ] = '\0';
             }
 
-            StringBuffer(): StringBuffer{ 255 }
+            explicit StringBuffer( std::size_t reserved ): StringBuffer{}
             {
+                reserve( reserved );
             }
 
-            explicit StringBuffer( char const * ch ): StringBuffer{ strlen( ch ) + 1 }
+            explicit StringBuffer( std::string_view str ): StringBuffer{}
             {
-                strcpy( data, ch );
-                current += size;
+                append( str );
             }
-            
-            StringBuffer( StringBuffer && strbuf ):
-                data( strbuf.data ),
-                current( strbuf.current ),
-                end( strbuf.end ),
-                size( strbuf.size )
+
+            StringBuffer( StringBuffer && strbuf ) noexcept: StringBuffer{}
             {
-                strbuf.data = nullptr;
-                strbuf.current = nullptr;
-                strbuf.end = nullptr;
-                strbuf.size = 0;
+                take( strbuf );
             }
 
             StringBuffer& operator=( StringBuffer const & strbuf ) = delete;
             StringBuffer( StringBuffer const & ) = delete;
 
-            StringBuffer& operator=( StringBuffer && buf )
+            StringBuffer& operator=( StringBuffer && buf ) noexcept
             {
                 if( this != &buf ){
-                    free( data );
-                    data = buf.data; buf.data = nullptr;
-                    current = buf.current; buf.current = nullptr;
-                    end = buf.end; buf.end = nullptr;
-                    size = buf.size; buf.size = 0;
+                    release();
+                    take( buf );
                 }
                 return *this;
             }
+
             ~StringBuffer()
             {
-                free( data );
+                release();
             }
 
             void clear()
             {
-                if( current > data ){
-                    memset( data, '\0', length() );
-                    current = data;
-                }
+                m_length = 0;
+                m_data[ 0 ] = '\0';
             }
-            
+
             std::size_t length() const
             {
-                return current - data;
+                return m_length;
             }
-            
+
             std::size_t capacity() const
             {
-                return size;
+                return m_capacity;
             }
-            
-            void enlarge_space()
+
+            bool is_inline() const
             {
-                std::size_t new_size = size * 2;
-                char *new_data = static_cast< char * >( calloc( new_size, 1 ) );
-                char *new_current = new_data + length();
-                char *new_end = new_data + new_size;
+                return m_data == m_inline;
+            }
 
-                memcpy( new_data, data, size );
-                free( data );
-                
-                data = new_data;
-                current = new_current;
-                end = new_end;
-                size = new_size;
+            char * data() { return m_data; }
+            char const * data() const { return m_data; }
+            char const * c_str() const { return m_data; }
+            std::string_view view() const { return std::string_view{ m_data, m_length }; }
+
+            void reserve( std::size_t new_capacity )
+            {
+                if( new_capacity <= m_capacity ){
+                    return;
+                }
+                // one extra byte for the terminator
+                char *new_data = static_cast< char * >( JPARSER_REALLOC( is_inline() ? nullptr : m_data, new_capacity + 1 ) );
+                if( !new_data ){
+                    throw std::bad_alloc{};
+                }
+                if( is_inline() ){
+                    std::memcpy( new_data, m_inline, m_length + 1 );
+                }
+                m_data = new_data;
+                m_capacity = new_capacity;
             }
+
             char& operator[]( std::size_t pos )
             {
-                return data[ pos ];
+                return m_data[ pos ];
             }
-            
+
             char const & operator[]( std::size_t pos ) const
             {
-                return data[ pos ];
+                return m_data[ pos ];
             }
-            
-            StringBuffer& operator+=( char const * str )
+
+            StringBuffer& operator+=( std::string_view str )
             {
                 append( str );
                 return *this;
             }
 
+            StringBuffer& operator+=( char const ch )
+            {
+                append( ch );
+                return *this;
+            }
+
             std::string to_string () const
             {
-                return std::string { data };
+                return std::string { m_data, m_length };
             }
 
             int to_int() const
             {
-                return std::stoi( data );
+                return std::stoi( to_string() );
             }
-            void append( char const * str )
+
+            void append( std::string_view str )
             {
-                std::size_t length_of_string = strlen( str );
-                while( current + length_of_string >= end ){
-                    enlarge_space();
+                if( m_length + str.size() > m_capacity ){
+                    grow( m_length + str.size() );
                 }
-                strcpy( current, str );
-                current += length_of_string;
+                std::memcpy( m_data + m_length, str.data(), str.size() );
+                m_length += str.size();
+                m_data[ m_length ] = '\0';
             }
-            void append( std::string const & str )
-            {
-                append( str.c_str() );
-            }
-            
+
             void append( char const ch )
             {
-                if( current + 1 >= end ){
-                    enlarge_space();
+                if( m_length == m_capacity ){
+                    grow( m_length + 1 );
                 }
-                *current = ch;
-                ++current;
+                m_data[ m_length ] = ch;
+                m_data[ ++m_length ] = '\0';
             }
+
             template< typename T >
             friend inline T &operator<<( T & os, StringBuffer const & strbuf )
             {
-                return os << strbuf.data;
+                return os << strbuf.view();
             }
+        private:
+            void grow( std::size_t required )
+            {
+                std::size_t const doubled = m_capacity * 2;
+                reserve( required < doubled ? doubled : required );
+            }
+
+            void release()
+            {
+                if( !is_inline() ){
+                    JPARSER_FREE( m_data );
+                }
+                m_data = m_inline;
+                m_length = 0;
+                m_capacity = inline_capacity;
+                m_inline[ 0 ] = '\0';
+            }
+
+            // Steals the heap block of `buf`, or copies its inline bytes, and leaves
+            // `buf` empty. Expects *this to be empty and inline.
+            void take( StringBuffer & buf )
+            {
+                if( buf.is_inline() ){
+                    std::memcpy( m_inline, buf.m_inline, buf.m_length + 1 );
+                } else {
+                    m_data = buf.m_data;
+                    m_capacity = buf.m_capacity;
+                    buf.m_data = buf.m_inline;
+                    buf.m_capacity = inline_capacity;
+                }
+                m_length = buf.m_length;
+                buf.m_length = 0;
+                buf.m_inline[ 0 ] = '\0';
+            }
+        private:
+            char *m_data;
+            std::size_t m_length;
+            std::size_t m_capacity;
+            char m_inline[ inline_capacity + 1 ];
         };
     }
 }
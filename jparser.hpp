@@ -2,5 +2,7 @@
 #define JPARSER_H_INCLUDED
 
 #include "include/JsonExpressionBuilder.hpp"
+#include "include/Formatter.hpp"
+#include "include/StaticDocument.hpp"
 
 #endif // JPARSER_H_INCLUDED